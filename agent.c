@@ -0,0 +1,359 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "agent.h"
+#include "clock.h"
+
+#define DEFAULT_ROLLOUTS 400
+#define DEFAULT_DEPTH 40
+// What a rollout scores when the player escaped, and at most when it ran out of turns
+#define SCORE_ESCAPED 1000
+#define SCORE_CLOSEST 500
+
+static const char agentMoves[4] = {'w', 'a', 's', 'd'};
+
+/*
+    What one thread needs: its own game to play rollouts on, and its share of the rollouts as the range
+    [next, end), packed into one word (next in the high half) so it can be taken from with a single
+    compare and swap, by its owner from the front and by thieves from the back. Lanes are kept a cache line
+    apart so the threads don't fight over each other's counters.
+*/
+struct AgentLane {
+    _Alignas(64) atomic_ullong range;
+    struct Game* game;
+    long long scores[4];
+    long long visits[4];
+    unsigned long long rollouts;
+    unsigned long long ticks;
+    unsigned long long stolen;
+    long long busyNanoseconds;
+};
+
+struct Agent {
+    struct Pool* pool;
+    int depth;
+    int numLanes;
+    struct AgentLane* lanes;
+    // The game the move is being picked for, which every rollout starts from
+    struct GameSnapshot* root;
+    unsigned long long rolloutKey;
+    // Set when the budget is time rather than a number of rollouts
+    long long deadline;
+    struct AgentStats stats;
+};
+
+static void runLane(void* agent, int lane);
+static int takeRollout(struct Agent*, struct AgentLane*, unsigned int* rollout);
+static void playRollout(struct Agent*, struct AgentLane*, unsigned int rollout);
+static void printAgentUsage(void);
+
+struct Agent* createAgent(const struct Game* game, struct Pool* pool, int depth) {
+    struct Agent* agent = calloc(1, sizeof(struct Agent));
+    if (agent == NULL) {
+        return NULL;
+    }
+    agent -> pool = pool;
+    agent -> depth = depth > 0 ? depth : 1;
+    agent -> numLanes = poolThreads(pool);
+    agent -> lanes = aligned_alloc(_Alignof(struct AgentLane), agent -> numLanes * sizeof(struct AgentLane));
+    agent -> root = malloc(snapshotSize(game));
+    if (agent -> lanes == NULL || agent -> root == NULL) {
+        free(agent -> lanes);
+        free(agent -> root);
+        free(agent);
+        return NULL;
+    }
+    memset(agent -> lanes, 0, agent -> numLanes * sizeof(struct AgentLane));
+    for (int i = 0; i < agent -> numLanes; i++) {
+        agent -> lanes[i].game = forkGame(game);
+        if (agent -> lanes[i].game == NULL) {
+            destroyAgent(agent);
+            return NULL;
+        }
+    }
+    return agent;
+}
+
+void destroyAgent(struct Agent* agent) {
+    if (agent == NULL) {
+        return;
+    }
+    for (int i = 0; i < agent -> numLanes; i++) {
+        destroyGame(agent -> lanes[i].game);
+    }
+    free(agent -> lanes);
+    free(agent -> root);
+    free(agent);
+}
+
+const struct AgentStats* agentStats(const struct Agent* agent) {
+    return &agent -> stats;
+}
+
+char agentMove(struct Agent* agent, const struct Game* game, long rollouts, long microseconds) {
+    long long start = monotonicNanoseconds();
+    saveGame(game, agent -> root);
+    // Rollouts are numbered, and each one's moves come from its number and the game, not from the thread it ran on
+    agent -> rolloutKey = ((unsigned long long)game -> roundKey << 32 | (game -> ticks & 0xFFFFFFFF)) ^ 0xA5A5A5A5DEADBEEFULL;
+    agent -> deadline = rollouts > 0 ? 0 : start + microseconds * 1000LL;
+
+    for (int i = 0; i < agent -> numLanes; i++) {
+        struct AgentLane* lane = &agent -> lanes[i];
+        unsigned long long first = rollouts > 0 ? (unsigned long long)rollouts * i / agent -> numLanes : 0;
+        unsigned long long last = rollouts > 0 ? (unsigned long long)rollouts * (i + 1) / agent -> numLanes : 0;
+        atomic_store(&lane -> range, first << 32 | last);
+        memset(lane -> scores, 0, sizeof(lane -> scores));
+        memset(lane -> visits, 0, sizeof(lane -> visits));
+    }
+    runPool(agent -> pool, agent -> numLanes, runLane, agent);
+
+    // The move whose rollouts scored best on average, the first of them on a tie
+    long long scores[4] = {0, 0, 0, 0};
+    long long visits[4] = {0, 0, 0, 0};
+    for (int i = 0; i < agent -> numLanes; i++) {
+        for (int move = 0; move < 4; move++) {
+            scores[move] += agent -> lanes[i].scores[move];
+            visits[move] += agent -> lanes[i].visits[move];
+        }
+    }
+    int best = 0;
+    for (int move = 1; move < 4; move++) {
+        // scores[move] / visits[move] > scores[best] / visits[best], without dividing
+        if (visits[move] > 0 && (visits[best] == 0 || scores[move] * visits[best] > scores[best] * visits[move])) {
+            best = move;
+        }
+    }
+
+    agent -> stats.moves++;
+    agent -> stats.rollouts = 0;
+    agent -> stats.ticks = 0;
+    agent -> stats.stolen = 0;
+    agent -> stats.busyNanoseconds = 0;
+    for (int i = 0; i < agent -> numLanes; i++) {
+        agent -> stats.rollouts += agent -> lanes[i].rollouts;
+        agent -> stats.ticks += agent -> lanes[i].ticks;
+        agent -> stats.stolen += agent -> lanes[i].stolen;
+        agent -> stats.busyNanoseconds += agent -> lanes[i].busyNanoseconds;
+    }
+    agent -> stats.wallNanoseconds += monotonicNanoseconds() - start;
+    return agentMoves[best];
+}
+
+static void runLane(void* argument, int index) {
+    struct Agent* agent = argument;
+    struct AgentLane* lane = &agent -> lanes[index];
+    long long start = monotonicNanoseconds();
+
+    if (agent -> deadline > 0) {
+        // Against the clock every lane just keeps going, numbering its rollouts apart from the other lanes'
+        for (unsigned int rollout = index; monotonicNanoseconds() < agent -> deadline; rollout += agent -> numLanes) {
+            playRollout(agent, lane, rollout);
+        }
+    }
+    else {
+        unsigned int rollout;
+        while (takeRollout(agent, lane, &rollout)) {
+            playRollout(agent, lane, rollout);
+        }
+    }
+    lane -> busyNanoseconds += monotonicNanoseconds() - start;
+}
+
+/*
+    Takes the next rollout off the front of the lane's own range. Once that is empty, steals the back half of
+    the fullest other lane's range and carries on with that. Returns 0 when there is nothing left anywhere.
+*/
+static int takeRollout(struct Agent* agent, struct AgentLane* lane, unsigned int* rollout) {
+    while (1) {
+        unsigned long long range = atomic_load(&lane -> range);
+        unsigned long long next = range >> 32;
+        unsigned long long end = range & 0xFFFFFFFF;
+        if (next < end) {
+            if (atomic_compare_exchange_weak(&lane -> range, &range, (next + 1) << 32 | end)) {
+                *rollout = (unsigned int)next;
+                return 1;
+            }
+            continue;
+        }
+
+        struct AgentLane* victim = NULL;
+        unsigned long long most = 0;
+        for (int i = 0; i < agent -> numLanes; i++) {
+            unsigned long long other = atomic_load(&agent -> lanes[i].range);
+            unsigned long long left = (other & 0xFFFFFFFF) - (other >> 32 < (other & 0xFFFFFFFF) ? other >> 32 : other & 0xFFFFFFFF);
+            if (left > most) {
+                most = left;
+                victim = &agent -> lanes[i];
+            }
+        }
+        if (victim == NULL) {
+            return 0;
+        }
+        unsigned long long taken = atomic_load(&victim -> range);
+        unsigned long long victimNext = taken >> 32;
+        unsigned long long victimEnd = taken & 0xFFFFFFFF;
+        if (victimNext >= victimEnd) {
+            continue;
+        }
+        unsigned long long middle = victimNext + (victimEnd - victimNext) / 2;
+        if (!atomic_compare_exchange_strong(&victim -> range, &taken, victimNext << 32 | middle)) {
+            continue;
+        }
+        // Nobody steals from an empty range, so this lane's own is only ever written by its owner here
+        atomic_store(&lane -> range, (middle + 1) << 32 | victimEnd);
+        lane -> stolen += victimEnd - middle;
+        *rollout = (unsigned int)middle;
+        return 1;
+    }
+}
+
+/*
+    Plays the rollout's move, then random ones, until the round ends or depth turns have gone by.
+    Rollout n tries move n % 4, so every move gets its share of any budget.
+*/
+static void playRollout(struct Agent* agent, struct AgentLane* lane, unsigned int rollout) {
+    struct Game* game = lane -> game;
+    int move = rollout % 4;
+    unsigned long long inputState = agent -> rolloutKey ^ ((unsigned long long)rollout * 0x9E3779B97F4A7C15ULL);
+
+    restoreGame(game, agent -> root);
+    enum GameOutcome outcome = stepGame(game, agentMoves[move]);
+    int turns = 1;
+    for (; turns < agent -> depth && outcome == GAME_RUNNING; turns++) {
+        outcome = stepGame(game, agentMoves[nextRandom(&inputState) % 4]);
+    }
+
+    long long score = 0;
+    if (outcome == GAME_ESCAPED) {
+        score = SCORE_ESCAPED;
+    }
+    else if (outcome == GAME_RUNNING) {
+        // Closer to the door is better, as the crow flies
+        const struct Map* map = game -> map;
+        int away = abs(game -> Player.xcoord - game -> Escape.xcoord) + abs(game -> Player.ycoord - game -> Escape.ycoord);
+        score = SCORE_CLOSEST - (long long)SCORE_CLOSEST * away / (map -> rows + map -> columns);
+    }
+    lane -> scores[move] += score;
+    lane -> visits[move]++;
+    lane -> rollouts++;
+    lane -> ticks += turns;
+}
+
+/*
+    zombies --agent [options]
+    Plays --games games, one after another, with the agent picking every move.
+*/
+int runAgent(int argc, char* argv[]) {
+    unsigned long long games = 10;
+    unsigned long long seed = time(0);
+    unsigned long maxTicks = 1000;
+    long rollouts = DEFAULT_ROLLOUTS;
+    long moveMicroseconds = 0;
+    int depth = DEFAULT_DEPTH;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int zombies = -1;
+    const char* mapPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            maxTicks = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--rollouts") == 0 && i + 1 < argc) {
+            rollouts = atol(argv[++i]);
+            moveMicroseconds = 0;
+        }
+        else if (strcmp(argv[i], "--move-ms") == 0 && i + 1 < argc) {
+            moveMicroseconds = (long)(atof(argv[++i]) * 1000);
+            rollouts = 0;
+        }
+        else if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--zombies") == 0 && i + 1 < argc) {
+            zombies = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            mapPath = argv[++i];
+        }
+        else {
+            printAgentUsage();
+            return 1;
+        }
+    }
+    if ((rollouts <= 0 && moveMicroseconds <= 0) || rollouts > 0xFFFFFFFFL) {
+        printAgentUsage();
+        return 1;
+    }
+
+    char error[100];
+    struct Map* map = mapPath != NULL ? loadMap(mapPath, error, sizeof(error)) : createOfficeMap();
+    if (map == NULL) {
+        printf("%s\n", mapPath != NULL ? error : "Not enough memory for the map.");
+        return 1;
+    }
+    struct Game* game = createGame(map, seed, zombies >= 0 ? zombies : map -> numZombieSpawns);
+    struct Pool* pool = createPool(threads);
+    struct Agent* agent = game != NULL && pool != NULL ? createAgent(game, pool, depth) : NULL;
+    if (agent == NULL) {
+        printf("Not enough memory for the agent.\n");
+        destroyPool(pool);
+        destroyGame(game);
+        destroyMap(map);
+        return 1;
+    }
+
+    unsigned long long escaped = 0;
+    unsigned long long died = 0;
+    unsigned long long ticks = 0;
+    long long start = monotonicNanoseconds();
+    for (unsigned long long i = 0; i < games; i++) {
+        seedGame(game, seed + i);
+        enum GameOutcome outcome = GAME_RUNNING;
+        while (outcome == GAME_RUNNING && game -> ticks < maxTicks) {
+            outcome = stepGame(game, agentMove(agent, game, rollouts, moveMicroseconds));
+        }
+        escaped += outcome == GAME_ESCAPED;
+        died += outcome == GAME_DIED;
+        ticks += game -> ticks;
+    }
+    double seconds = secondsSince(start);
+
+    const struct AgentStats* stats = agentStats(agent);
+    printf("games: %llu  zombies: %d  threads: %d  depth: %d  seed: %llu  seconds: %.3f\n", games, game -> numZombies,
+        poolThreads(pool), depth, seed, seconds);
+    if (games > 0) {
+        printf("escaped: %.2f%%  died: %.2f%%  timed out: %.2f%%  moves/game: %.1f\n", 100.0 * escaped / games,
+            100.0 * died / games, 100.0 * (games - escaped - died) / games, (double)ticks / games);
+    }
+    if (stats -> moves > 0 && stats -> busyNanoseconds > 0) {
+        printf("rollouts/move: %.0f  ms/move: %.2f  rollouts/sec: %.0f  rollouts/sec/core: %.0f  ticks/sec/core: %.0f  stolen: %.1f%%\n",
+            (double)stats -> rollouts / stats -> moves, stats -> wallNanoseconds / 1e6 / stats -> moves,
+            stats -> rollouts / (stats -> wallNanoseconds / 1e9), stats -> rollouts / (stats -> busyNanoseconds / 1e9),
+            stats -> ticks / (stats -> busyNanoseconds / 1e9), stats -> rollouts > 0 ? 100.0 * stats -> stolen / stats -> rollouts : 0.0);
+    }
+
+    destroyAgent(agent);
+    destroyPool(pool);
+    destroyGame(game);
+    destroyMap(map);
+    return 0;
+}
+
+static void printAgentUsage(void) {
+    printf("usage: zombies --agent [--games N] [--seed S] [--max-ticks T] [--rollouts N | --move-ms MS] [--depth D] [--threads N] [--zombies N] [--map FILE]\n");
+}
@@ -0,0 +1,46 @@
+#ifndef AGENT_H
+#define AGENT_H
+
+#include "game.h"
+#include "pool.h"
+
+/*
+    An automated player. Each turn it tries every move by playing many random rounds (rollouts) on from it,
+    and picks the move whose rollouts went best: escaping scores most, dying nothing, and a rollout that runs
+    out of turns scores by how close the player got to the door.
+
+    Rollouts run on the pool's threads, each of which plays them on its own fork of the game, so nothing is
+    shared but the map. With a rollout budget the work is split evenly and threads that finish early steal
+    from the others; the move picked then only depends on the game and the budget, not on the threads.
+*/
+struct Agent;
+
+struct AgentStats {
+    unsigned long moves;
+    unsigned long long rollouts;
+    unsigned long long ticks;
+    // Time the threads spent on rollouts, added up over all of them
+    long long busyNanoseconds;
+    // Time from asking for a move to getting it
+    long long wallNanoseconds;
+    // Rollouts a thread stole from another after running out of its own
+    unsigned long long stolen;
+};
+
+// Plays games like game on the pool's threads. depth is how many turns a rollout looks ahead. NULL when out of memory.
+struct Agent* createAgent(const struct Game* game, struct Pool* pool, int depth);
+void destroyAgent(struct Agent*);
+/*
+    Picks w, a, s or d for game. Runs rollouts rollouts, or if that is 0, as many as fit in microseconds.
+    The game is only read.
+*/
+char agentMove(struct Agent*, const struct Game* game, long rollouts, long microseconds);
+const struct AgentStats* agentStats(const struct Agent*);
+
+/*
+    Plays games with the agent and reports how often it escaped, as a gauge of how hard a map and horde are,
+    along with rollouts/sec per core. Takes the command line that follows "--agent".
+*/
+int runAgent(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,227 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "clock.h"
+#include "game.h"
+#include "pool.h"
+
+// Games are handed out to the worker threads in chunks of this size
+#define BATCH_CHUNK 256
+
+struct BatchOptions {
+    unsigned long long games;
+    unsigned long long seed;
+    unsigned long maxTicks;
+    int threads;
+    // Threads each game's horde is shared out over, the worker's own included; only hordes of thousands make use of them
+    int hordeThreads;
+    int zombies;
+    // Sets every game's levelOfDetail
+    char levelOfDetail;
+    const struct Map* map;
+    // Inputs are read from here in a loop. When empty, every game gets its own random w/a/s/d stream.
+    const char* script;
+};
+
+struct BatchTotals {
+    unsigned long long escaped;
+    unsigned long long died;
+    unsigned long long timedOut;
+    unsigned long long ticks;
+};
+
+struct BatchWorker {
+    pthread_t thread;
+    const struct BatchOptions* options;
+    atomic_ullong* nextGame;
+    struct BatchTotals totals;
+};
+
+static void* runBatchWorker(void*);
+static void playGame(struct Game*, const struct BatchOptions*, unsigned long long gameNumber, struct BatchTotals*);
+static void printBatchUsage(void);
+
+int runBatch(int argc, char* argv[]) {
+    struct BatchOptions options;
+    options.games = 1000000;
+    options.seed = time(0);
+    options.maxTicks = 1000;
+    options.threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    options.hordeThreads = 1;
+    options.zombies = -1;
+    options.levelOfDetail = 0;
+    const char* mapPath = NULL;
+    options.script = "";
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            options.games = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            options.maxTicks = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            options.threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--horde-threads") == 0 && i + 1 < argc) {
+            options.hordeThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--zombies") == 0 && i + 1 < argc) {
+            options.zombies = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            mapPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            options.script = argv[++i];
+        }
+        else if (strcmp(argv[i], "--lod") == 0) {
+            options.levelOfDetail = 1;
+        }
+        else {
+            printBatchUsage();
+            return 1;
+        }
+    }
+    if (options.threads < 1) {
+        options.threads = 1;
+    }
+
+    // Every thread plays on the same map
+    char error[100];
+    struct Map* map = mapPath != NULL ? loadMap(mapPath, error, sizeof(error)) : createOfficeMap();
+    if (map == NULL) {
+        printf("%s\n", mapPath != NULL ? error : "Not enough memory for the map.");
+        return 1;
+    }
+    options.map = map;
+    if (options.zombies < 0) {
+        options.zombies = map -> numZombieSpawns;
+    }
+
+    struct BatchWorker* workers = calloc(options.threads, sizeof(struct BatchWorker));
+    if (workers == NULL) {
+        printf("Not enough memory for %d worker threads.\n", options.threads);
+        destroyMap(map);
+        return 1;
+    }
+
+    atomic_ullong nextGame = 0;
+    long long start = monotonicNanoseconds();
+
+    int started = 0;
+    for (; started < options.threads; started++) {
+        workers[started].options = &options;
+        workers[started].nextGame = &nextGame;
+        if (pthread_create(&workers[started].thread, NULL, runBatchWorker, &workers[started]) != 0) {
+            break;
+        }
+    }
+
+    struct BatchTotals totals;
+    memset(&totals, 0, sizeof(totals));
+    for (int i = 0; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        totals.escaped += workers[i].totals.escaped;
+        totals.died += workers[i].totals.died;
+        totals.timedOut += workers[i].totals.timedOut;
+        totals.ticks += workers[i].totals.ticks;
+    }
+    double seconds = secondsSince(start);
+    free(workers);
+    destroyMap(map);
+
+    unsigned long long played = totals.escaped + totals.died + totals.timedOut;
+    if (played == 0) {
+        printf("No games were played.\n");
+        return 1;
+    }
+
+    printf("games: %llu  zombies: %d  threads: %d  seed: %llu  seconds: %.3f\n", played, options.zombies, started, options.seed, seconds);
+    printf("games/sec: %.0f  ticks/sec: %.0f\n", played / seconds, totals.ticks / seconds);
+    printf("escaped: %.2f%%  died: %.2f%%  timed out: %.2f%%\n",
+        100.0 * totals.escaped / played, 100.0 * totals.died / played, 100.0 * totals.timedOut / played);
+    return 0;
+}
+
+static void* runBatchWorker(void* argument) {
+    struct BatchWorker* worker = argument;
+    const struct BatchOptions* options = worker -> options;
+
+    struct Game* game = createGame(options -> map, options -> seed, options -> zombies);
+    if (game == NULL) {
+        return NULL;
+    }
+    game -> levelOfDetail = options -> levelOfDetail;
+    // Without its pool the game still plays, and the same, just on this thread alone
+    struct Pool* pool = options -> hordeThreads > 1 ? createPool(options -> hordeThreads) : NULL;
+    game -> pool = pool;
+
+    while (1) {
+        unsigned long long first = atomic_fetch_add(worker -> nextGame, BATCH_CHUNK);
+        if (first >= options -> games) {
+            break;
+        }
+        unsigned long long last = first + BATCH_CHUNK;
+        if (last > options -> games) {
+            last = options -> games;
+        }
+        for (unsigned long long gameNumber = first; gameNumber < last; gameNumber++) {
+            playGame(game, options, gameNumber, &worker -> totals);
+        }
+    }
+
+    destroyGame(game);
+    destroyPool(pool);
+    return NULL;
+}
+
+static void playGame(struct Game* game, const struct BatchOptions* options, unsigned long long gameNumber, struct BatchTotals* totals) {
+    static const char moves[4] = {'w', 'a', 's', 'd'};
+
+    // Each game gets its own seed, so the result of a game never depends on which thread played it
+    unsigned long long gameSeed = options -> seed + gameNumber;
+    unsigned long long inputState = gameSeed ^ 0x5DEECE66DULL;
+    size_t scriptLength = strlen(options -> script);
+    enum GameOutcome outcome = GAME_RUNNING;
+
+    seedGame(game, gameSeed);
+    for (unsigned long tick = 0; tick < options -> maxTicks && outcome == GAME_RUNNING; tick++) {
+        char input;
+        if (scriptLength > 0) {
+            input = options -> script[tick % scriptLength];
+        }
+        else {
+            input = moves[nextRandom(&inputState) % 4];
+        }
+        outcome = stepGame(game, input);
+    }
+
+    totals -> ticks += game -> ticks;
+    switch (outcome) {
+    case GAME_ESCAPED:
+        totals -> escaped++;
+        break;
+    case GAME_DIED:
+        totals -> died++;
+        break;
+    default:
+        totals -> timedOut++;
+        break;
+    }
+}
+
+static void printBatchUsage(void) {
+    printf("usage: zombies --batch [--games N] [--seed S] [--max-ticks T] [--threads N] [--horde-threads N] [--zombies N] [--map FILE] [--script wasd...] [--lod]\n");
+}
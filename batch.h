@@ -0,0 +1,10 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+/*
+    Runs many headless games across every core and reports throughput and win/loss rates.
+    Takes the command line that follows "--batch".
+*/
+int runBatch(int argc, char* argv[]);
+
+#endif
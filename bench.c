@@ -0,0 +1,514 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "game.h"
+#include "render.h"
+
+// Every case is timed this many times and the fastest kept: noise from other processes only ever adds time
+#define SAMPLES 7
+// Each sample repeats its case until at least this long has passed
+#define SAMPLE_NANOSECONDS 30000000LL
+// How far over its baseline a case may get before the run counts as a regression, in percent
+#define DEFAULT_TOLERANCE 25.0
+// Most cases a baseline file may hold
+#define BASELINE_CAPACITY 64
+#define HORDE 10000
+// Zombies the far horde cases add on top of HORDE, at least FAR_FROM rows and columns from the player's start
+#define FAR_ZOMBIES (3 * HORDE)
+#define FAR_FROM 128
+#define SEED 1
+
+/*
+    What a case runs against. Cases on the office play the two zombies everyone knows; cases on the warehouse
+    play a horde of HORDE, which is where per zombie costs show up.
+*/
+struct BenchState {
+    struct Game* game;
+    // The game as it was set up, for the cases that branch off it
+    struct GameSnapshot* snapshot;
+    struct Renderer* renderer;
+    unsigned long long inputState;
+};
+
+/*
+    A benchmark case. run does one timed block of work and returns how many operations that was;
+    between, if set, puts things back in shape between blocks without being timed.
+*/
+struct BenchCase {
+    const char* name;
+    // 0 for the office, 1 for the warehouse
+    int warehouse;
+    long (*run)(struct BenchState*);
+    void (*between)(struct BenchState*);
+    // How many zombies go on the warehouse past its horde, far from the player
+    int farZombies;
+};
+
+struct BenchResult {
+    char name[64];
+    double nanoseconds;
+};
+
+static long runMoveLeft(struct BenchState*);
+static long runMoveRight(struct BenchState*);
+static long runMoveUp(struct BenchState*);
+static long runMoveDown(struct BenchState*);
+static long runAggressive(struct BenchState*);
+static long runPassive(struct BenchState*);
+static long runReset(struct BenchState*);
+static long runBranch(struct BenchState*);
+static long runFork(struct BenchState*);
+static long runRenderFull(struct BenchState*);
+static long runRenderDiff(struct BenchState*);
+static long runTick(struct BenchState*);
+static long runDetailedTick(struct BenchState*);
+static void undoLeft(struct BenchState*);
+static void undoRight(struct BenchState*);
+static void undoUp(struct BenchState*);
+static void undoDown(struct BenchState*);
+static void walkPlayer(struct BenchState*);
+static void startOver(struct BenchState*);
+
+static const struct BenchCase cases[] = {
+    {"moveZombieLeft", 1, runMoveLeft, undoLeft, 0},
+    {"moveZombieRight", 1, runMoveRight, undoRight, 0},
+    {"moveZombieUp", 1, runMoveUp, undoUp, 0},
+    {"moveZombieDown", 1, runMoveDown, undoDown, 0},
+    {"AggressiveZombieMotion/office", 0, runAggressive, walkPlayer, 0},
+    {"AggressiveZombieMotion/horde", 1, runAggressive, walkPlayer, 0},
+    {"randomPassiveZombieMotion", 1, runPassive, walkPlayer, 0},
+    {"resetGame/office", 0, runReset, NULL, 0},
+    {"resetGame/horde", 1, runReset, NULL, 0},
+    {"branch/office", 0, runBranch, NULL, 0},
+    {"branch/horde", 1, runBranch, NULL, 0},
+    {"forkGame/horde", 1, runFork, NULL, 0},
+    {"render/full", 0, runRenderFull, NULL, 0},
+    {"render/diff", 0, runRenderDiff, NULL, 0},
+    {"tick/office", 0, runTick, NULL, 0},
+    {"tick/horde", 1, runTick, NULL, 0},
+    {"tick/horde-lod", 1, runDetailedTick, startOver, 0},
+    {"tick/horde-lod-far", 1, runDetailedTick, startOver, FAR_ZOMBIES},
+};
+
+static double timeCase(const struct BenchCase*, struct Map* map, struct Pool* pool);
+static struct Game* createFarHorde(const struct Map*, int farZombies);
+static int readResults(const char* path, struct BenchResult* results, int capacity);
+
+/*
+    Times the game's hot functions on fixed seeds and horde sizes, and prints nanoseconds per operation.
+    --threads gives the horde's games a thread pool. --output saves the results as "name<TAB>ns/op" lines. --baseline compares them with an earlier such file
+    and fails if any case got slower by more than --tolerance percent, or if the run and the baseline don't have
+    the same cases. Times only mean something against a baseline recorded on the same machine and build, so each
+    machine records its own; the one checked in is just where the numbers in the README came from.
+*/
+int main(int argc, char* argv[]) {
+    const char* filter = NULL;
+    const char* outputPath = NULL;
+    const char* baselinePath = NULL;
+    const char* warehousePath = "maps/warehouse.txt";
+    double tolerance = DEFAULT_TOLERANCE;
+    int threads = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warehouse") == 0 && i + 1 < argc) {
+            warehousePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else {
+            printf("usage: bench [--filter TEXT] [--output FILE] [--baseline FILE] [--tolerance PERCENT] [--warehouse MAP] [--threads N]\n");
+            return 1;
+        }
+    }
+
+    char error[100];
+    struct Map* maps[2];
+    maps[0] = createOfficeMap();
+    maps[1] = loadMap(warehousePath, error, sizeof(error));
+    if (maps[0] == NULL || maps[1] == NULL) {
+        printf("%s\n", maps[1] == NULL ? error : "Not enough memory for the map.");
+        destroyMap(maps[0]);
+        destroyMap(maps[1]);
+        return 1;
+    }
+
+    // The horde's games share out their zombies over this pool
+    struct Pool* pool = threads > 1 ? createPool(threads) : NULL;
+    int numCases = sizeof(cases) / sizeof(cases[0]);
+    struct BenchResult results[sizeof(cases) / sizeof(cases[0])];
+    int numResults = 0;
+    for (int i = 0; i < numCases; i++) {
+        if (filter != NULL && strstr(cases[i].name, filter) == NULL) {
+            continue;
+        }
+        double nanoseconds = timeCase(&cases[i], maps[cases[i].warehouse], cases[i].warehouse ? pool : NULL);
+        if (nanoseconds < 0) {
+            printf("Not enough memory to run %s.\n", cases[i].name);
+            destroyPool(pool);
+            destroyMap(maps[0]);
+            destroyMap(maps[1]);
+            return 1;
+        }
+        snprintf(results[numResults].name, sizeof(results[numResults].name), "%s", cases[i].name);
+        results[numResults].nanoseconds = nanoseconds;
+        printf("%-32s %12.1f ns/op\n", cases[i].name, nanoseconds);
+        fflush(stdout);
+        numResults++;
+    }
+    destroyPool(pool);
+    destroyMap(maps[0]);
+    destroyMap(maps[1]);
+
+    if (outputPath != NULL) {
+        FILE* output = fopen(outputPath, "w");
+        if (output == NULL) {
+            printf("Couldn't write %s.\n", outputPath);
+            return 1;
+        }
+        for (int i = 0; i < numResults; i++) {
+            fprintf(output, "%s\t%.1f\n", results[i].name, results[i].nanoseconds);
+        }
+        fclose(output);
+    }
+
+    if (baselinePath == NULL) {
+        return 0;
+    }
+    struct BenchResult baseline[BASELINE_CAPACITY];
+    int numBaseline = readResults(baselinePath, baseline, BASELINE_CAPACITY);
+    if (numBaseline < 0) {
+        printf("Couldn't read the baseline %s.\n", baselinePath);
+        return 1;
+    }
+    if (numBaseline > BASELINE_CAPACITY) {
+        printf("The baseline %s has %d cases, more than the %d there are room for.\n", baselinePath, numBaseline, BASELINE_CAPACITY);
+        return 1;
+    }
+    // A case run with no baseline, or a baseline the run should have covered and didn't, means the baseline
+    // is from another version of the suite, and a comparison that leaves cases out can't be trusted to pass
+    int regressions = 0;
+    int unmatched = 0;
+    printf("\ncompared with %s (tolerance %.0f%%):\n", baselinePath, tolerance);
+    for (int i = 0; i < numResults; i++) {
+        int j = 0;
+        while (j < numBaseline && strcmp(results[i].name, baseline[j].name) != 0) {
+            j++;
+        }
+        if (j == numBaseline) {
+            unmatched++;
+            printf("%-32s %12s -> %12.1f ns/op  NOT IN BASELINE\n", results[i].name, "", results[i].nanoseconds);
+            continue;
+        }
+        double change = 100.0 * (results[i].nanoseconds - baseline[j].nanoseconds) / baseline[j].nanoseconds;
+        char regressed = change > tolerance;
+        regressions += regressed;
+        printf("%-32s %12.1f -> %12.1f ns/op  %+7.1f%%%s\n", results[i].name, baseline[j].nanoseconds,
+            results[i].nanoseconds, change, regressed ? "  REGRESSION" : "");
+    }
+    for (int j = 0; j < numBaseline; j++) {
+        if (filter != NULL && strstr(baseline[j].name, filter) == NULL) {
+            continue;
+        }
+        int i = 0;
+        while (i < numResults && strcmp(results[i].name, baseline[j].name) != 0) {
+            i++;
+        }
+        if (i == numResults) {
+            unmatched++;
+            printf("%-32s %12.1f -> %12s        NO SUCH CASE\n", baseline[j].name, baseline[j].nanoseconds, "");
+        }
+    }
+    if (regressions > 0) {
+        printf("%d case%s regressed.\n", regressions, regressions == 1 ? "" : "s");
+    }
+    if (unmatched > 0) {
+        printf("%d case%s didn't match the baseline; record a new one with --output (the benchmark-baseline target).\n",
+            unmatched, unmatched == 1 ? "" : "s");
+    }
+    return regressions > 0 || unmatched > 0;
+}
+
+// Fewest nanoseconds per operation of any sample of a case, or -1 if its game couldn't be set up
+static double timeCase(const struct BenchCase* benchCase, struct Map* map, struct Pool* pool) {
+    struct BenchState state;
+    if (benchCase -> farZombies > 0) {
+        state.game = createFarHorde(map, benchCase -> farZombies);
+    }
+    else {
+        state.game = createGame(map, SEED, benchCase -> warehouse ? HORDE : map -> numZombieSpawns);
+    }
+    state.renderer = createRenderer(VIEW_ROWS, VIEW_COLUMNS);
+    state.snapshot = state.game != NULL ? malloc(snapshotSize(state.game)) : NULL;
+    state.inputState = SEED;
+    if (state.game == NULL || state.renderer == NULL || state.snapshot == NULL) {
+        free(state.snapshot);
+        destroyGame(state.game);
+        destroyRenderer(state.renderer);
+        return -1;
+    }
+    saveGame(state.game, state.snapshot);
+    state.game -> pool = pool;
+    state.renderer -> fd = open("/dev/null", O_WRONLY);
+
+    double samples[SAMPLES];
+    for (int sample = 0; sample < SAMPLES; sample++) {
+        long long elapsed = 0;
+        long operations = 0;
+        while (elapsed < SAMPLE_NANOSECONDS) {
+            long long start = monotonicNanoseconds();
+            operations += benchCase -> run(&state);
+            elapsed += monotonicNanoseconds() - start;
+            if (benchCase -> between != NULL) {
+                benchCase -> between(&state);
+            }
+        }
+        samples[sample] = (double)elapsed / operations;
+    }
+
+    close(state.renderer -> fd);
+    free(state.snapshot);
+    destroyRenderer(state.renderer);
+    destroyGame(state.game);
+    double fastest = samples[0];
+    for (int sample = 1; sample < SAMPLES; sample++) {
+        if (samples[sample] < fastest) {
+            fastest = samples[sample];
+        }
+    }
+    return fastest;
+}
+
+/*
+    The warehouse's horde of HORDE, where it always starts, and farZombies more on random floor tiles at least
+    FAR_FROM rows and columns from the player's start, where they start every round. The player's neighbourhood
+    looks just like it does with HORDE, so any time the extra zombies add is what they cost from far away.
+*/
+static struct Game* createFarHorde(const struct Map* map, int farZombies) {
+    // The first HORDE zombies go where they would in a game of HORDE, as the same seed places them the same way
+    struct Game* game = createGame(map, SEED, HORDE + farZombies);
+    struct Spawn* zombies = game != NULL ? malloc(game -> numZombies * sizeof(struct Spawn)) : NULL;
+    char* taken = calloc(map -> cells, 1);
+    if (game == NULL || zombies == NULL || taken == NULL || game -> numZombies < HORDE + farZombies) {
+        destroyGame(game);
+        free(zombies);
+        free(taken);
+        return NULL;
+    }
+    for (int i = 0; i < HORDE; i++) {
+        zombies[i].xcoord = game -> zombies[i].startingX;
+        zombies[i].ycoord = game -> zombies[i].startingY;
+        taken[cellIndex(map, zombies[i].ycoord, zombies[i].xcoord)] = 1;
+    }
+
+    unsigned long long spawnState = SEED;
+    int rows = map -> rows - FAR_FROM - map -> playerSpawn.ycoord;
+    int columns = map -> columns - FAR_FROM - map -> playerSpawn.xcoord;
+    long attempts = 0;
+    int placed = HORDE;
+    while (placed < game -> numZombies && rows > 0 && columns > 0 && attempts++ < 1000L * farZombies) {
+        int row = map -> playerSpawn.ycoord + FAR_FROM + nextRandom(&spawnState) % rows;
+        int column = map -> playerSpawn.xcoord + FAR_FROM + nextRandom(&spawnState) % columns;
+        int cell = cellIndex(map, row, column);
+        if (map -> tiles[cell] != TILE_FLOOR || taken[cell]) {
+            continue;
+        }
+        taken[cell] = 1;
+        zombies[placed].xcoord = column;
+        zombies[placed].ycoord = row;
+        placed++;
+    }
+    if (placed < game -> numZombies) {
+        // The far corner of the map is too small for them
+        destroyGame(game);
+        free(zombies);
+        free(taken);
+        return NULL;
+    }
+
+    struct Spawn player = {game -> Player.startingX, game -> Player.startingY};
+    placeActors(game, player, zombies, 0);
+    saveGame(game, game -> start);
+    free(zombies);
+    free(taken);
+    return game;
+}
+
+/*
+    The moveZombie cases try to step every zombie one way, then (untimed) step them all back, so the horde
+    stays where it started and the mix of blocked and open moves stays the same from block to block.
+*/
+static long moveAll(struct BenchState* state, char (*move)(struct Game*, struct Actor*)) {
+    struct Game* game = state -> game;
+    for (int i = 0; i < game -> numZombies; i++) {
+        move(game, &game -> zombies[i]);
+    }
+    return game -> numZombies;
+}
+
+static long runMoveLeft(struct BenchState* state) {
+    return moveAll(state, moveZombieLeft);
+}
+
+static long runMoveRight(struct BenchState* state) {
+    return moveAll(state, moveZombieRight);
+}
+
+static long runMoveUp(struct BenchState* state) {
+    return moveAll(state, moveZombieUp);
+}
+
+static long runMoveDown(struct BenchState* state) {
+    return moveAll(state, moveZombieDown);
+}
+
+static void undoLeft(struct BenchState* state) {
+    moveAll(state, moveZombieRight);
+}
+
+static void undoRight(struct BenchState* state) {
+    moveAll(state, moveZombieLeft);
+}
+
+static void undoUp(struct BenchState* state) {
+    moveAll(state, moveZombieDown);
+}
+
+static void undoDown(struct BenchState* state) {
+    moveAll(state, moveZombieUp);
+}
+
+static long runAggressive(struct BenchState* state) {
+    struct Game* game = state -> game;
+    for (int i = 0; i < game -> numZombies; i++) {
+        AggressiveZombieMotion(game, &game -> zombies[i]);
+    }
+    return game -> numZombies;
+}
+
+static long runPassive(struct BenchState* state) {
+    struct Game* game = state -> game;
+    for (int i = 0; i < game -> numZombies; i++) {
+        randomPassiveZombieMotion(game, &game -> zombies[i]);
+    }
+    return game -> numZombies;
+}
+
+// Plays a tick of random input between blocks, so zombies keep having somewhere to go, starting over as games end
+static void walkPlayer(struct BenchState* state) {
+    static const char moves[4] = {'w', 'a', 's', 'd'};
+    if (stepGame(state -> game, moves[nextRandom(&state -> inputState) % 4]) != GAME_RUNNING) {
+        resetGame(state -> game);
+    }
+}
+
+static void startOver(struct BenchState* state) {
+    if (gameOutcome(state -> game) != GAME_RUNNING) {
+        resetGame(state -> game);
+    }
+}
+
+static long runReset(struct BenchState* state) {
+    resetGame(state -> game);
+    return 1;
+}
+
+// One tick of play and back again, the way a search tries a move
+static long runBranch(struct BenchState* state) {
+    walkPlayer(state);
+    restoreGame(state -> game, state -> snapshot);
+    return 1;
+}
+
+static long runFork(struct BenchState* state) {
+    destroyGame(forkGame(state -> game));
+    return 1;
+}
+
+static long runRenderFull(struct BenchState* state) {
+    struct Game* game = state -> game;
+    invalidateRenderer(state -> renderer);
+    renderFrame(state -> renderer, game, viewStart(game -> Player.ycoord, game -> map -> rows, VIEW_ROWS),
+        viewStart(game -> Player.xcoord, game -> map -> columns, VIEW_COLUMNS), "");
+    return 1;
+}
+
+// A frame after one tick of play, which is what the game draws almost all of the time
+static long runRenderDiff(struct BenchState* state) {
+    struct Game* game = state -> game;
+    walkPlayer(state);
+    renderFrame(state -> renderer, game, viewStart(game -> Player.ycoord, game -> map -> rows, VIEW_ROWS),
+        viewStart(game -> Player.xcoord, game -> map -> columns, VIEW_COLUMNS), "");
+    return 1;
+}
+
+// Ticks of random input, starting over as games end
+static long runTick(struct BenchState* state) {
+    for (int i = 0; i < 64; i++) {
+        walkPlayer(state);
+    }
+    return 64;
+}
+
+/*
+    Ticks of random input with the horde's far away zombies simulated at a lower level of detail, up to the end
+    of the round. It is started over between blocks, as resetting puts back every zombie that moved, which
+    would grow with the horde and hide whether the ticks do.
+*/
+static long runDetailedTick(struct BenchState* state) {
+    static const char moves[4] = {'w', 'a', 's', 'd'};
+    state -> game -> levelOfDetail = 1;
+    for (int i = 0; i < 64; i++) {
+        if (stepGame(state -> game, moves[nextRandom(&state -> inputState) % 4]) != GAME_RUNNING) {
+            return i + 1;
+        }
+    }
+    return 64;
+}
+
+// Reads "name<TAB>ns/op" lines as written by --output, keeping the first capacity of them. Returns how many there
+// were, which can be more than it kept, or -1 if the file can't be read.
+static int readResults(const char* path, struct BenchResult* results, int capacity) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return -1;
+    }
+    int count = 0;
+    char line[128];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        struct BenchResult result;
+        char* tab = strchr(line, '\t');
+        if (tab == NULL || tab - line >= (long)sizeof(result.name)) {
+            continue;
+        }
+        *tab = '\0';
+        strcpy(result.name, line);
+        result.nanoseconds = atof(tab + 1);
+        if (result.nanoseconds > 0) {
+            if (count < capacity) {
+                results[count] = result;
+            }
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
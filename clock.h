@@ -0,0 +1,9 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+// Nanoseconds on the monotonic clock, which never jumps with the time of day, for timing things within a run
+long long monotonicNanoseconds(void);
+// Seconds since start, an earlier reading of monotonicNanoseconds
+double secondsSince(long long start);
+
+#endif
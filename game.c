@@ -0,0 +1,1248 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "stats.h"
+
+// Icons are shared by every tile and actor of a kind instead of being copied into each one
+static const char tileIcons[][3] = {"  ", "- ", "| ", "+ "};
+static const char playerIcons[][3] = {"X ", "^ ", "< ", "v ", "> "};
+static const char zombieIcon[] = "Z ";
+static const char escapeIcon[] = "  ";
+
+static const int directionX[4] = {0, -1, 0, 1};
+static const int directionY[4] = {-1, 0, 1, 0};
+
+// Zombies this many rows or columns from the player come after them
+#define AGGRESSIVE_RANGE 4
+// Distance of a cell the player can't be reached from
+#define UNREACHABLE INT_MAX
+// What the flow field reads at its source when it is searched. Everything in the field stays above 0 however
+// far the player walks before the next search, so a 0 can mean a cell isn't in it.
+#define FIELD_ZERO (1 << 30)
+
+/*
+    With GCC or Clang, on a target with a 32 bit vector multiply (SSE4.1, AVX2, NEON), passive zombies are
+    proposed ZOMBIE_LANES at a time with the compiler's vector extensions: random numbers, directions, target
+    cells and who is aggressive are worked out for the whole block at once, and only the bitboard lookups go
+    lane by lane. Plain x86-64 has to emulate the multiply and does better one zombie at a time, as do other
+    compilers and builds with ZOMBIES_SCALAR defined. Either way every zombie picks the same step.
+*/
+#if defined(__GNUC__) && !defined(ZOMBIES_SCALAR) && (defined(__SSE4_1__) || defined(__AVX2__) || defined(__ARM_NEON))
+#define ZOMBIE_LANES 8
+typedef int LaneInt __attribute__((vector_size(ZOMBIE_LANES * sizeof(int))));
+typedef unsigned int LaneWord __attribute__((vector_size(ZOMBIE_LANES * sizeof(unsigned int))));
+#endif
+
+// Out of 256, the odds a far away zombie ends its turn of LOD_FAR_PERIOD steps in the next region over
+#define LOD_HOP_CHANCE 102
+// Keeps far away zombies' random numbers apart from the ones they wander with up close
+#define LOD_KEY 0x5BD1E995u
+
+// murmur3's finaliser, for one number or a vector of them alike
+#define MIX_BITS(x) do { \
+    x ^= x >> 16; \
+    x *= 0x85EBCA6Bu; \
+    x ^= x >> 13; \
+    x *= 0xC2B2AE35u; \
+    x ^= x >> 16; \
+} while (0)
+
+static void movePlayer(struct Game*, char input);
+static void proposeMoves(struct Game*, int first, int last);
+static void proposeDetailed(struct Game*, int first, int last);
+static void gatherDetailed(struct Game*);
+static void fileZombies(struct Game*);
+static void refileZombie(struct Game*, int zombie);
+static void moveFarZombies(struct Game*);
+#ifdef ZOMBIE_LANES
+static void proposeLanes(struct Game*, int first);
+#endif
+static void proposeChunk(void* game, int chunk);
+static enum Direction aggressiveStep(const struct Game*, const struct Actor*);
+static enum Direction passiveStep(const struct Game*, int zombie);
+static struct Game* allocateGame(const struct Map*, int numZombies);
+static void spawnHorde(struct Game*, unsigned long long seed);
+static void buildLegalMoves(struct Game*, int first, int last);
+static void buildLegalChunk(void* game, int chunk);
+static void commitMoves(struct Game*);
+static void refreshLegalMoves(struct Game*, int from, int to);
+static void rebuildLegalAround(struct Game*, int cell);
+static void rebuildFlowField(struct Game*, int source, int radius);
+static void stepFlowField(struct Game*, int source);
+static void unstepFlowField(struct Game*);
+static void recoverFlowField(struct Game*);
+static void updateFlowField(struct Game*);
+
+static inline int testBit(const unsigned long long* bits, int cell) {
+    return (bits[cell >> 6] >> (cell & 63)) & 1;
+}
+
+static inline void setBit(unsigned long long* bits, int cell) {
+    bits[cell >> 6] |= 1ULL << (cell & 63);
+}
+
+static inline void clearBit(unsigned long long* bits, int cell) {
+    bits[cell >> 6] &= ~(1ULL << (cell & 63));
+}
+
+static inline int distanceToPlayer(const struct Game* game, int cell) {
+    int distance = game -> distances[cell];
+    return distance == 0 ? UNREACHABLE : distance - FIELD_ZERO + game -> distanceBase;
+}
+
+static inline int actorCell(const struct Game* game, const struct Actor* actor) {
+    return cellIndex(game -> map, actor -> ycoord, actor -> xcoord);
+}
+
+static inline int actorRegion(const struct Game* game, const struct Actor* actor) {
+    return actor -> ycoord / MAP_REGION_SIDE * game -> map -> regionColumns + actor -> xcoord / MAP_REGION_SIDE;
+}
+
+// Which zombie takes the turn-th step of this tick: every one in order, or with levelOfDetail the detailed ones
+static inline int turnZombie(const struct Game* game, int turn) {
+    return game -> levelOfDetail ? game -> detailed[turn] : turn;
+}
+
+static inline int lowestBit(unsigned long long bits) {
+#ifdef __GNUC__
+    return __builtin_ctzll(bits);
+#else
+    int bit = 0;
+    while (!(bits >> bit & 1)) {
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+// Handle Zombie movement - If within 4 tiles of a zombie, they will purposefully come after you. Otherwise, they meander randomly
+static inline int isAggressive(const struct Game* game, const struct Actor* Zombie) {
+    return abs(Zombie -> xcoord - game -> Player.xcoord) <= AGGRESSIVE_RANGE || abs(Zombie -> ycoord - game -> Player.ycoord) <= AGGRESSIVE_RANGE;
+}
+
+// Counter based random number: the same key, tick and zombie always give the same 32 bits
+static inline unsigned int zombieRandom(unsigned int key, unsigned int tick, unsigned int zombie) {
+    unsigned int x = key ^ (tick * 0x9E3779B9u) ^ (zombie * 0x85EBCA6Bu);
+    MIX_BITS(x);
+    return x;
+}
+
+/*
+    A wandering zombie's direction from its random number: bit 0 picks the axis (0 for up and down),
+    bit 1 the way along it (0 for down or right). With the directions numbered up, left, down, right,
+    that comes down to flipping bit 1, so it needs no branches.
+*/
+static inline enum Direction randomDirection(unsigned int random) {
+    return (enum Direction)((random ^ 2) & 3);
+}
+
+struct Game* createGame(const struct Map* map, unsigned long long seed, int numZombies) {
+    struct Game* game = allocateGame(map, numZombies);
+    if (game == NULL) {
+        return NULL;
+    }
+    spawnHorde(game, seed);
+
+    // Every round starts from the same snapshot: everyone on their starting tile, at tick 0
+    game -> start = malloc(snapshotSize(game));
+    if (game -> start == NULL) {
+        destroyGame(game);
+        return NULL;
+    }
+    struct Spawn start = {game -> Player.startingX, game -> Player.startingY};
+    placeActors(game, start, NULL, 0);
+    game -> Player.facing = FACING_NONE;
+    saveGame(game, game -> start);
+
+    seedGame(game, seed);
+    return game;
+}
+
+struct Game* forkGame(const struct Game* original) {
+    struct Game* game = allocateGame(original -> map, original -> numZombies);
+    struct GameSnapshot* now = malloc(snapshotSize(original));
+    if (game != NULL) {
+        game -> start = malloc(snapshotSize(original));
+    }
+    if (game == NULL || now == NULL || game -> start == NULL) {
+        destroyGame(game);
+        free(now);
+        return NULL;
+    }
+    memcpy(game -> start, original -> start, snapshotSize(original));
+    game -> levelOfDetail = original -> levelOfDetail;
+    for (int i = 0; i < game -> numZombies; i++) {
+        game -> zombies[i].startingX = original -> zombies[i].startingX;
+        game -> zombies[i].startingY = original -> zombies[i].startingY;
+    }
+
+    // Everyone goes on the board where they are now, and the rest follows from the snapshot
+    saveGame(original, now);
+    placeActors(game, now -> player, now -> zombies, now -> ticks);
+    restoreGame(game, now);
+    free(now);
+    return game;
+}
+
+// A game with all its memory, nobody on the board and no horde placed
+static struct Game* allocateGame(const struct Map* map, int numZombies) {
+    struct Game* game = calloc(1, sizeof(struct Game));
+    if (game == NULL) {
+        return NULL;
+    }
+
+    if (numZombies < 0) {
+        numZombies = 0;
+    }
+    game -> map = map;
+    game -> numZombies = numZombies;
+    game -> zombies = calloc(numZombies > 0 ? numZombies : 1, sizeof(struct Actor));
+    game -> moves = calloc(numZombies > 0 ? numZombies : 1, 1);
+    game -> zombieBits = calloc(map -> words, sizeof(unsigned long long));
+    game -> playerBits = calloc(map -> words, sizeof(unsigned long long));
+    game -> distances = calloc(map -> cells, sizeof(int));
+    // Nothing further than FLOW_RADIUS steps from the player ever makes it into the flow field
+    long fieldCapacity = 2L * FLOW_RADIUS * (FLOW_RADIUS + 1) + 1;
+    if (fieldCapacity > map -> cells) {
+        fieldCapacity = map -> cells;
+    }
+    game -> fieldCells = malloc(fieldCapacity * sizeof(int));
+    game -> fieldQueue = malloc(fieldCapacity * sizeof(int));
+    // Only a game with levelOfDetail ever writes to these, so nobody else's pages get touched
+    int zombieSlots = numZombies > 0 ? numZombies : 1;
+    game -> regionFirst = malloc((size_t)map -> regionRows * map -> regionColumns * sizeof(int));
+    game -> regionNext = malloc(zombieSlots * sizeof(int));
+    game -> regionPrevious = malloc(zombieSlots * sizeof(int));
+    game -> zombieRegion = malloc(zombieSlots * sizeof(int));
+    game -> detailedBits = calloc((zombieSlots + 63) / 64, sizeof(unsigned long long));
+    game -> detailed = malloc(zombieSlots * sizeof(int));
+    char allocated = game -> zombies != NULL && game -> moves != NULL && game -> zombieBits != NULL && game -> playerBits != NULL
+        && game -> distances != NULL && game -> fieldCells != NULL && game -> fieldQueue != NULL
+        && game -> regionFirst != NULL && game -> regionNext != NULL && game -> regionPrevious != NULL
+        && game -> zombieRegion != NULL && game -> detailedBits != NULL && game -> detailed != NULL;
+    for (int direction = 0; direction < 4; direction++) {
+        game -> legalMoves[direction] = calloc(map -> words, sizeof(unsigned long long));
+        allocated = allocated && game -> legalMoves[direction] != NULL;
+    }
+    if (!allocated) {
+        destroyGame(game);
+        return NULL;
+    }
+    game -> fieldSource = -1;
+    game -> fieldPathLength = FLOW_PATH_MAX + 1;
+
+    // Player generation
+    game -> Player.kind = ACTOR_PLAYER;
+    game -> Player.startingX = map -> playerSpawn.xcoord;
+    game -> Player.startingY = map -> playerSpawn.ycoord;
+    game -> Player.xcoord = game -> Player.startingX;
+    game -> Player.ycoord = game -> Player.startingY;
+
+    // Escape door generation
+    game -> Escape.kind = ACTOR_ESCAPE;
+    game -> Escape.facing = FACING_NONE;
+    game -> Escape.startingX = map -> escapeSpawn.xcoord;
+    game -> Escape.startingY = map -> escapeSpawn.ycoord;
+
+    // Zombie generation
+    for (int i = 0; i < numZombies; i++) {
+        game -> zombies[i].kind = ACTOR_ZOMBIE;
+        game -> zombies[i].facing = FACING_NONE;
+    }
+    return game;
+}
+
+void destroyGame(struct Game* game) {
+    if (game == NULL) {
+        return;
+    }
+    free(game -> zombies);
+    free(game -> moves);
+    free(game -> zombieBits);
+    free(game -> playerBits);
+    for (int direction = 0; direction < 4; direction++) {
+        free(game -> legalMoves[direction]);
+    }
+    free(game -> distances);
+    free(game -> fieldCells);
+    free(game -> fieldQueue);
+    free(game -> regionFirst);
+    free(game -> regionNext);
+    free(game -> regionPrevious);
+    free(game -> zombieRegion);
+    free(game -> detailedBits);
+    free(game -> detailed);
+    free(game -> start);
+    free(game);
+}
+
+/*
+    Zombies start on the map's zombie spawns first. The rest go on random free floor tiles, found by picking
+    tiles at random until one fits. Tiles within 4 of the player's start are left alone so a game can't be
+    lost before the first move. If the floor runs out, the horde is cut down to what fits.
+*/
+static void spawnHorde(struct Game* game, unsigned long long seed) {
+    const struct Map* map = game -> map;
+    unsigned long long spawnState = seed ^ 0xC0FFEE;
+    // zombieBits is still empty here, so it can keep track of the tiles handed out
+    unsigned long long* taken = game -> zombieBits;
+    int placed = 0;
+
+    for (; placed < game -> numZombies && placed < map -> numZombieSpawns; placed++) {
+        game -> zombies[placed].startingX = map -> zombieSpawns[placed].xcoord;
+        game -> zombies[placed].startingY = map -> zombieSpawns[placed].ycoord;
+        setBit(taken, cellIndex(map, map -> zombieSpawns[placed].ycoord, map -> zombieSpawns[placed].xcoord));
+    }
+
+    long attempts = 0;
+    long maxAttempts = 1000L * (game -> numZombies + 1);
+    while (placed < game -> numZombies && attempts++ < maxAttempts) {
+        int row = nextRandom(&spawnState) % map -> rows;
+        int column = nextRandom(&spawnState) % map -> columns;
+        int cell = cellIndex(map, row, column);
+        if (!testBit(map -> floorBits, cell) || testBit(taken, cell)
+            || (abs(column - game -> Player.startingX) <= 4 && abs(row - game -> Player.startingY) <= 4)
+            || (column == game -> Escape.startingX && row == game -> Escape.startingY)) {
+            continue;
+        }
+        setBit(taken, cell);
+        game -> zombies[placed].startingX = column;
+        game -> zombies[placed].startingY = row;
+        placed++;
+    }
+    game -> numZombies = placed;
+
+    for (int i = 0; i < placed; i++) {
+        clearBit(taken, cellIndex(map, game -> zombies[i].startingY, game -> zombies[i].startingX));
+    }
+}
+
+void seedGame(struct Game* game, unsigned long long seed) {
+    game -> rngState = seed;
+    resetGame(game);
+}
+
+// Only the random number state carries over from one round to the next
+void resetGame(struct Game* game) {
+    STATS_BEGIN(PHASE_RESET);
+    unsigned long long rngState = game -> rngState;
+    restoreGame(game, game -> start);
+    game -> rngState = rngState;
+    game -> roundKey = nextRandom(&game -> rngState);
+    STATS_END(PHASE_RESET);
+}
+
+void placeActors(struct Game* game, struct Spawn player, const struct Spawn* zombies, unsigned long ticks) {
+    struct Actor* Player = &game -> Player;
+    struct Actor* Escape = &game -> Escape;
+
+    // Set up miscellaneous
+    game -> playerDied = 0;
+    game -> playerBlocked = 0;
+    game -> ticks = ticks;
+
+    // Clear the spaces of the player and zombies
+    clearBit(game -> playerBits, actorCell(game, Player));
+    for (int i = 0; i < game -> numZombies; i++) {
+        int cell = actorCell(game, &game -> zombies[i]);
+        clearBit(game -> zombieBits, cell);
+        for (int direction = 0; direction < 4; direction++) {
+            game -> legalMoves[direction][cell >> 6] = 0;
+        }
+    }
+
+    // Move all actors to their new coordinates
+    Player -> xcoord = player.xcoord;
+    Player -> ycoord = player.ycoord;
+    for (int i = 0; i < game -> numZombies; i++) {
+        game -> zombies[i].xcoord = zombies != NULL ? zombies[i].xcoord : game -> zombies[i].startingX;
+        game -> zombies[i].ycoord = zombies != NULL ? zombies[i].ycoord : game -> zombies[i].startingY;
+    }
+    Escape -> xcoord = Escape -> startingX;
+    Escape -> ycoord = Escape -> startingY;
+
+    // Place the actors on the map
+    setBit(game -> playerBits, actorCell(game, Player));
+    for (int i = 0; i < game -> numZombies; i++) {
+        setBit(game -> zombieBits, actorCell(game, &game -> zombies[i]));
+    }
+    if (game -> numZombies > game -> map -> words) {
+        buildLegalMoves(game, 0, game -> map -> words);
+    }
+    else {
+        for (int i = 0; i < game -> numZombies; i++) {
+            int word = actorCell(game, &game -> zombies[i]) >> 6;
+            buildLegalMoves(game, word, word + 1);
+        }
+    }
+    game -> regionsFiled = 0;
+    game -> fieldPathLength = FLOW_PATH_MAX + 1;
+}
+
+size_t snapshotSize(const struct Game* game) {
+    return sizeof(struct GameSnapshot) + game -> numZombies * sizeof(struct Spawn);
+}
+
+void saveGame(const struct Game* game, struct GameSnapshot* snapshot) {
+    snapshot -> ticks = game -> ticks;
+    snapshot -> rngState = game -> rngState;
+    snapshot -> roundKey = game -> roundKey;
+    snapshot -> playerDied = game -> playerDied;
+    snapshot -> playerBlocked = game -> playerBlocked;
+    snapshot -> playerFacing = game -> Player.facing;
+    snapshot -> fieldComplete = game -> fieldComplete;
+    snapshot -> fieldSource = game -> fieldSource;
+    snapshot -> distanceBase = game -> distanceBase;
+    snapshot -> fieldPathLength = game -> fieldPathLength;
+    memcpy(snapshot -> fieldPath, game -> fieldPath, sizeof(snapshot -> fieldPath));
+    snapshot -> numZombies = game -> numZombies;
+    snapshot -> player.xcoord = game -> Player.xcoord;
+    snapshot -> player.ycoord = game -> Player.ycoord;
+    for (int i = 0; i < game -> numZombies; i++) {
+        snapshot -> zombies[i].xcoord = game -> zombies[i].xcoord;
+        snapshot -> zombies[i].ycoord = game -> zombies[i].ycoord;
+    }
+}
+
+void restoreGame(struct Game* game, const struct GameSnapshot* snapshot) {
+    const struct Map* map = game -> map;
+    struct Actor* Player = &game -> Player;
+
+    game -> ticks = snapshot -> ticks;
+    game -> rngState = snapshot -> rngState;
+    game -> roundKey = snapshot -> roundKey;
+    game -> playerDied = snapshot -> playerDied;
+    game -> playerBlocked = snapshot -> playerBlocked;
+    Player -> facing = snapshot -> playerFacing;
+
+    clearBit(game -> playerBits, actorCell(game, Player));
+    Player -> xcoord = snapshot -> player.xcoord;
+    Player -> ycoord = snapshot -> player.ycoord;
+    setBit(game -> playerBits, actorCell(game, Player));
+
+    // Take every zombie that moved off the board before putting any back, as two of them may have swapped.
+    // Their coordinates change last, so the legal moves can still be worked out around where they were.
+    int moved = 0;
+    for (int i = 0; i < game -> numZombies; i++) {
+        const struct Actor* Zombie = &game -> zombies[i];
+        if (Zombie -> xcoord != snapshot -> zombies[i].xcoord || Zombie -> ycoord != snapshot -> zombies[i].ycoord) {
+            clearBit(game -> zombieBits, actorCell(game, Zombie));
+            moved++;
+        }
+    }
+    for (int i = 0; i < game -> numZombies && moved > 0; i++) {
+        const struct Actor* Zombie = &game -> zombies[i];
+        if (Zombie -> xcoord != snapshot -> zombies[i].xcoord || Zombie -> ycoord != snapshot -> zombies[i].ycoord) {
+            setBit(game -> zombieBits, cellIndex(map, snapshot -> zombies[i].ycoord, snapshot -> zombies[i].xcoord));
+        }
+    }
+    char wholeLayer = moved > map -> words / 8;
+    for (int i = 0; i < game -> numZombies && moved > 0; i++) {
+        struct Actor* Zombie = &game -> zombies[i];
+        if (Zombie -> xcoord != snapshot -> zombies[i].xcoord || Zombie -> ycoord != snapshot -> zombies[i].ycoord) {
+            if (!wholeLayer) {
+                rebuildLegalAround(game, actorCell(game, Zombie));
+                rebuildLegalAround(game, cellIndex(map, snapshot -> zombies[i].ycoord, snapshot -> zombies[i].xcoord));
+            }
+            Zombie -> xcoord = snapshot -> zombies[i].xcoord;
+            Zombie -> ycoord = snapshot -> zombies[i].ycoord;
+            if (game -> regionsFiled) {
+                refileZombie(game, i);
+            }
+        }
+    }
+    if (wholeLayer) {
+        buildLegalMoves(game, 0, map -> words);
+    }
+
+    // The flow field only has to be searched again if it isn't the one the snapshot had already
+    game -> fieldPathLength = snapshot -> fieldPathLength;
+    memcpy(game -> fieldPath, snapshot -> fieldPath, sizeof(game -> fieldPath));
+    if (snapshot -> fieldPathLength > FLOW_PATH_MAX) {
+        return;
+    }
+    // A game played on a tick from the snapshot has stepped its field at most once, which is quicker undone than searched
+    if (game -> fieldUndoLength > 0 && !game -> fieldRestored && game -> distanceBase == snapshot -> distanceBase + 1
+        && game -> fieldUndoFrom == snapshot -> fieldSource) {
+        unstepFlowField(game);
+    }
+    char sameField = !game -> fieldRestored && game -> fieldComplete == snapshot -> fieldComplete
+        && game -> fieldSource == snapshot -> fieldSource && game -> distanceBase == snapshot -> distanceBase;
+    if (!sameField) {
+        game -> fieldComplete = snapshot -> fieldComplete;
+        game -> fieldSource = snapshot -> fieldSource;
+        game -> distanceBase = snapshot -> distanceBase;
+        game -> fieldRestored = 1;
+    }
+}
+
+enum GameOutcome gameOutcome(const struct Game* game) {
+    if (game -> playerDied) {
+        return GAME_DIED;
+    }
+    if (game -> Player.xcoord == game -> Escape.xcoord && game -> Player.ycoord == game -> Escape.ycoord) {
+        return GAME_ESCAPED;
+    }
+    return GAME_RUNNING;
+}
+
+const char* cellIcon(const struct Game* game, int row, int column) {
+    int cell = cellIndex(game -> map, row, column);
+    if (testBit(game -> playerBits, cell)) {
+        return playerIcons[game -> Player.facing];
+    }
+    if (testBit(game -> zombieBits, cell)) {
+        return zombieIcon;
+    }
+    if (column == game -> Escape.xcoord && row == game -> Escape.ycoord) {
+        return escapeIcon;
+    }
+    return tileIcons[game -> map -> tiles[cell]];
+}
+
+/*
+    Advances the game by one turn: the player acts on the input, then every zombie takes its move.
+    Finished games are left untouched until they are reset.
+*/
+enum GameOutcome stepGame(struct Game* game, char input) {
+    enum GameOutcome outcome = gameOutcome(game);
+    if (outcome != GAME_RUNNING) {
+        return outcome;
+    }
+    STATS_BEGIN(PHASE_TICK);
+
+    STATS_BEGIN(PHASE_PLAYER);
+    movePlayer(game, input);
+    STATS_END(PHASE_PLAYER);
+
+    // With levelOfDetail, only the zombies near the player take a step of their own, and every aggressive one is among them
+    int turns = game -> numZombies;
+    if (game -> levelOfDetail) {
+        gatherDetailed(game);
+        turns = game -> numDetailed;
+    }
+
+    // Aggressive zombies all read the flow field, so it is brought up to date before any of them look,
+    // as long as there is one to look
+    if (game -> fieldPathLength != 0 || game -> fieldRestored) {
+        for (int turn = 0; turn < turns; turn++) {
+            if (isAggressive(game, &game -> zombies[turnZombie(game, turn)])) {
+                STATS_BEGIN(PHASE_FLOW_FIELD);
+                updateFlowField(game);
+                STATS_END(PHASE_FLOW_FIELD);
+                break;
+            }
+        }
+    }
+
+    // Every zombie picks its step from where everyone stands now
+    STATS_BEGIN(PHASE_PROPOSE);
+    if (game -> pool != NULL && turns > ZOMBIE_CHUNK) {
+        runPool(game -> pool, (turns + ZOMBIE_CHUNK - 1) / ZOMBIE_CHUNK, proposeChunk, game);
+    }
+    else {
+        proposeMoves(game, 0, turns);
+    }
+    STATS_END(PHASE_PROPOSE);
+
+    STATS_BEGIN(PHASE_COMMIT);
+    commitMoves(game);
+    if (game -> levelOfDetail) {
+        moveFarZombies(game);
+    }
+    STATS_END(PHASE_COMMIT);
+
+    // Check if the Player lost the game
+    STATS_BEGIN(PHASE_COLLISION);
+    if (testBit(game -> zombieBits, actorCell(game, &game -> Player))) {
+        game -> playerDied = 1;
+    }
+    STATS_END(PHASE_COLLISION);
+
+    game -> ticks++;
+    STATS_END(PHASE_TICK);
+    return gameOutcome(game);
+}
+
+static void movePlayer(struct Game* game, char input) {
+    struct Actor* Player = &game -> Player;
+    enum Direction direction;
+    unsigned char facing;
+
+    game -> playerBlocked = 0;
+    switch (input) {
+    case 'w':
+        direction = DIRECTION_UP;
+        facing = FACING_UP;
+        break;
+    case 'a':
+        direction = DIRECTION_LEFT;
+        facing = FACING_LEFT;
+        break;
+    case 's':
+        direction = DIRECTION_DOWN;
+        facing = FACING_DOWN;
+        break;
+    case 'd':
+        direction = DIRECTION_RIGHT;
+        facing = FACING_RIGHT;
+        break;
+    default:
+        return;
+    }
+
+    int from = actorCell(game, Player);
+    if (game -> map -> openDirections[from] & (1 << direction)) {
+        int cell = from + game -> map -> offsets[direction];
+        clearBit(game -> playerBits, from);
+        setBit(game -> playerBits, cell);
+        Player -> xcoord += directionX[direction];
+        Player -> ycoord += directionY[direction];
+        Player -> facing = facing;
+
+        // Remember the step for the flow field
+        if (game -> fieldPathLength < FLOW_PATH_MAX) {
+            game -> fieldPath[game -> fieldPathLength] = cell;
+        }
+        if (game -> fieldPathLength <= FLOW_PATH_MAX) {
+            game -> fieldPathLength++;
+        }
+    }
+    else {
+        game -> playerBlocked = 1;
+    }
+}
+
+static void proposeMoves(struct Game* game, int first, int last) {
+    if (game -> levelOfDetail) {
+        proposeDetailed(game, first, last);
+        return;
+    }
+    int i = first;
+#ifdef ZOMBIE_LANES
+    for (; i + ZOMBIE_LANES <= last; i += ZOMBIE_LANES) {
+        proposeLanes(game, i);
+    }
+#endif
+    for (; i < last; i++) {
+        const struct Actor* Zombie = &game -> zombies[i];
+        if (isAggressive(game, Zombie)) {
+            game -> moves[i] = aggressiveStep(game, Zombie);
+        }
+        else {
+            game -> moves[i] = passiveStep(game, i);
+        }
+    }
+}
+
+#ifdef ZOMBIE_LANES
+// proposeMoves for the ZOMBIE_LANES zombies from first on, picking exactly the steps it would one by one
+static void proposeLanes(struct Game* game, int first) {
+    const struct Actor* zombies = &game -> zombies[first];
+    LaneInt x;
+    LaneInt y;
+    LaneWord zombie;
+    for (int lane = 0; lane < ZOMBIE_LANES; lane++) {
+        x[lane] = zombies[lane].xcoord;
+        y[lane] = zombies[lane].ycoord;
+        zombie[lane] = first + lane;
+    }
+
+    // isAggressive, with |d| worked out as (d ^ sign) - sign
+    LaneInt dx = x - game -> Player.xcoord;
+    LaneInt dy = y - game -> Player.ycoord;
+    LaneInt aggressive = (((dx ^ (dx >> 31)) - (dx >> 31)) <= AGGRESSIVE_RANGE) | (((dy ^ (dy >> 31)) - (dy >> 31)) <= AGGRESSIVE_RANGE);
+    LaneInt cells = (y + 1) * game -> map -> stride + x;
+
+    LaneWord random = (unsigned int)game -> roundKey ^ ((unsigned int)game -> ticks * 0x9E3779B9u) ^ (zombie * 0x85EBCA6Bu);
+    MIX_BITS(random);
+    LaneWord directions = (random ^ 2) & 3;
+
+    for (int lane = 0; lane < ZOMBIE_LANES; lane++) {
+        if (aggressive[lane]) {
+            game -> moves[first + lane] = aggressiveStep(game, &zombies[lane]);
+        }
+        else {
+            enum Direction direction = (enum Direction)directions[lane];
+            game -> moves[first + lane] = testBit(game -> legalMoves[direction], cells[lane]) ? direction : DIRECTION_NONE;
+        }
+    }
+}
+#endif
+
+// proposeMoves with levelOfDetail, for the detailed zombies from the first-th up to the last-th
+static void proposeDetailed(struct Game* game, int first, int last) {
+    for (int turn = first; turn < last; turn++) {
+        int i = game -> detailed[turn];
+        const struct Actor* Zombie = &game -> zombies[i];
+        if (isAggressive(game, Zombie)) {
+            game -> moves[i] = aggressiveStep(game, Zombie);
+        }
+        else {
+            game -> moves[i] = passiveStep(game, i);
+        }
+    }
+}
+
+/*
+    Lists the zombies that step this tick with levelOfDetail. Zombies after the player, or within LOD_NEAR rows
+    and columns, step every tick. Those within LOD_MID step on their turn every LOD_MID_PERIOD ticks, staggered
+    by zombie number so a share of them go each tick. Everyone else stays put and is left to moveFarZombies.
+    Only the regions those zombies can be in are looked at: the ones within LOD_MID of the player, and the rows
+    and columns of regions level with them, so a horde growing away from the player costs nothing here.
+*/
+static void gatherDetailed(struct Game* game) {
+    const struct Map* map = game -> map;
+    const struct Actor* Player = &game -> Player;
+    if (!game -> regionsFiled) {
+        fileZombies(game);
+    }
+
+    // The first and last region rows and columns around the player, and level with them
+    int nearTop = (Player -> ycoord > LOD_MID ? Player -> ycoord - LOD_MID : 0) / MAP_REGION_SIDE;
+    int nearBottom = (Player -> ycoord + LOD_MID < map -> rows ? Player -> ycoord + LOD_MID : map -> rows - 1) / MAP_REGION_SIDE;
+    int nearLeft = (Player -> xcoord > LOD_MID ? Player -> xcoord - LOD_MID : 0) / MAP_REGION_SIDE;
+    int nearRight = (Player -> xcoord + LOD_MID < map -> columns ? Player -> xcoord + LOD_MID : map -> columns - 1) / MAP_REGION_SIDE;
+    int levelTop = (Player -> ycoord > AGGRESSIVE_RANGE ? Player -> ycoord - AGGRESSIVE_RANGE : 0) / MAP_REGION_SIDE;
+    int levelBottom = (Player -> ycoord + AGGRESSIVE_RANGE < map -> rows ? Player -> ycoord + AGGRESSIVE_RANGE : map -> rows - 1) / MAP_REGION_SIDE;
+    int levelLeft = (Player -> xcoord > AGGRESSIVE_RANGE ? Player -> xcoord - AGGRESSIVE_RANGE : 0) / MAP_REGION_SIDE;
+    int levelRight = (Player -> xcoord + AGGRESSIVE_RANGE < map -> columns ? Player -> xcoord + AGGRESSIVE_RANGE : map -> columns - 1) / MAP_REGION_SIDE;
+
+    for (int regionRow = 0; regionRow < map -> regionRows; regionRow++) {
+        char levelRow = regionRow >= levelTop && regionRow <= levelBottom;
+        char nearRow = regionRow >= nearTop && regionRow <= nearBottom;
+        for (int regionColumn = 0; regionColumn < map -> regionColumns; regionColumn++) {
+            if (!levelRow && !(nearRow && regionColumn >= nearLeft && regionColumn <= nearRight)
+                && !(regionColumn >= levelLeft && regionColumn <= levelRight)) {
+                continue;
+            }
+            for (int i = game -> regionFirst[regionRow * map -> regionColumns + regionColumn]; i >= 0; i = game -> regionNext[i]) {
+                const struct Actor* Zombie = &game -> zombies[i];
+                int dx = abs(Zombie -> xcoord - Player -> xcoord);
+                int dy = abs(Zombie -> ycoord - Player -> ycoord);
+                int away = dx > dy ? dx : dy;
+                if (isAggressive(game, Zombie) || away <= LOD_NEAR || (away <= LOD_MID && (game -> ticks + i) % LOD_MID_PERIOD == 0)) {
+                    setBit(game -> detailedBits, i);
+                }
+            }
+        }
+    }
+
+    // Reading the marks back word by word puts them in zombie order, which the steps are taken in
+    int count = 0;
+    for (int word = 0; word < (game -> numZombies + 63) / 64; word++) {
+        unsigned long long bits = game -> detailedBits[word];
+        game -> detailedBits[word] = 0;
+        for (; bits != 0; bits &= bits - 1) {
+            game -> detailed[count++] = word * 64 + lowestBit(bits);
+        }
+    }
+    game -> numDetailed = count;
+    STATS_COUNT(COUNTER_LOD_SKIPPED, game -> numZombies - count);
+}
+
+// Files every zombie under the region it stands in, from scratch
+static void fileZombies(struct Game* game) {
+    for (int region = 0; region < game -> map -> regionRows * game -> map -> regionColumns; region++) {
+        game -> regionFirst[region] = -1;
+    }
+    for (int i = 0; i < game -> numZombies; i++) {
+        game -> zombieRegion[i] = -1;
+        refileZombie(game, i);
+    }
+    game -> regionsFiled = 1;
+}
+
+// Moves a zombie to the list of the region it stands in now, if it isn't on that one already
+static void refileZombie(struct Game* game, int zombie) {
+    int region = actorRegion(game, &game -> zombies[zombie]);
+    int old = game -> zombieRegion[zombie];
+    if (region == old) {
+        return;
+    }
+    int next = game -> regionNext[zombie];
+    int previous = game -> regionPrevious[zombie];
+    if (old >= 0) {
+        if (previous >= 0) {
+            game -> regionNext[previous] = next;
+        }
+        else {
+            game -> regionFirst[old] = next;
+        }
+        if (next >= 0) {
+            game -> regionPrevious[next] = previous;
+        }
+    }
+    next = game -> regionFirst[region];
+    game -> regionNext[zombie] = next;
+    game -> regionPrevious[zombie] = -1;
+    if (next >= 0) {
+        game -> regionPrevious[next] = zombie;
+    }
+    game -> regionFirst[region] = zombie;
+    game -> zombieRegion[zombie] = region;
+}
+
+/*
+    Zombies further than LOD_MID from the player get a turn once every LOD_FAR_PERIOD ticks, a share of them
+    each tick, found without looking at anyone else. Wandering that many steps at random takes a zombie about
+    five tiles along each axis, so instead of walking it, it ends up in the next region over with odds of
+    about two in five: through a side of its region that floor crosses, onto a random tile of that region.
+    If the tile isn't free floor, it stays where it is.
+*/
+static void moveFarZombies(struct Game* game) {
+    const struct Map* map = game -> map;
+    int hops = 0;
+
+    for (int i = (LOD_FAR_PERIOD - game -> ticks % LOD_FAR_PERIOD) % LOD_FAR_PERIOD; i < game -> numZombies; i += LOD_FAR_PERIOD) {
+        // Most turns end here, before the zombie itself is looked at, which on a big horde is a cache miss
+        unsigned int random = zombieRandom(game -> roundKey ^ LOD_KEY, (unsigned int)game -> ticks, i);
+        if ((random & 255) >= LOD_HOP_CHANCE) {
+            continue;
+        }
+        struct Actor* Zombie = &game -> zombies[i];
+        int dx = abs(Zombie -> xcoord - game -> Player.xcoord);
+        int dy = abs(Zombie -> ycoord - game -> Player.ycoord);
+        if ((dx <= LOD_MID && dy <= LOD_MID) || isAggressive(game, Zombie)) {
+            continue;
+        }
+
+        // One of the open sides, picked with the next bits
+        int regionRow = Zombie -> ycoord / MAP_REGION_SIDE;
+        int regionColumn = Zombie -> xcoord / MAP_REGION_SIDE;
+        unsigned char open = map -> regionOpen[regionRow * map -> regionColumns + regionColumn];
+        int sides = (open & 1) + (open >> 1 & 1) + (open >> 2 & 1) + (open >> 3 & 1);
+        if (sides == 0) {
+            continue;
+        }
+        int pick = (random >> 8 & 255) % sides;
+        int direction = 0;
+        while (!(open & (1 << direction)) || pick-- > 0) {
+            direction++;
+        }
+
+        int row = (regionRow + directionY[direction]) * MAP_REGION_SIDE + (random >> 16 & 255) % MAP_REGION_SIDE;
+        int column = (regionColumn + directionX[direction]) * MAP_REGION_SIDE + (random >> 24) % MAP_REGION_SIDE;
+        if (row >= map -> rows || column >= map -> columns) {
+            continue;
+        }
+        int from = actorCell(game, Zombie);
+        int to = cellIndex(map, row, column);
+        if (!testBit(map -> floorBits, to) || testBit(game -> zombieBits, to)) {
+            continue;
+        }
+        clearBit(game -> zombieBits, from);
+        setBit(game -> zombieBits, to);
+        Zombie -> xcoord = column;
+        Zombie -> ycoord = row;
+        refileZombie(game, i);
+        refreshLegalMoves(game, from, to);
+        hops++;
+    }
+    STATS_COUNT(COUNTER_LOD_HOPS, hops);
+}
+
+/*
+    The steps are taken in zombie order. Nobody picked a cell a zombie stood on when the tick began, so the
+    only steps that fail are onto a cell a lower numbered zombie has just moved into.
+    Once everyone has moved, the legal moves around each step are worked out again, or the whole layer is
+    rebuilt when the horde is so big that most of it has changed anyway.
+*/
+static void commitMoves(struct Game* game) {
+    const int* offsets = game -> map -> offsets;
+    int turns = game -> levelOfDetail ? game -> numDetailed : game -> numZombies;
+    int moved = 0;
+    int blocked = 0;
+    int contested = 0;
+
+    for (int turn = 0; turn < turns; turn++) {
+        int i = turnZombie(game, turn);
+        enum Direction direction = game -> moves[i];
+        if (direction == DIRECTION_NONE) {
+            blocked++;
+            continue;
+        }
+        struct Actor* Zombie = &game -> zombies[i];
+        int from = actorCell(game, Zombie);
+        int to = from + offsets[direction];
+        if (testBit(game -> zombieBits, to)) {
+            game -> moves[i] = DIRECTION_NONE;
+            contested++;
+            continue;
+        }
+        clearBit(game -> zombieBits, from);
+        setBit(game -> zombieBits, to);
+        Zombie -> xcoord += directionX[direction];
+        Zombie -> ycoord += directionY[direction];
+        if (game -> levelOfDetail) {
+            refileZombie(game, i);
+        }
+        moved++;
+    }
+    if (!game -> levelOfDetail && moved > 0) {
+        game -> regionsFiled = 0;
+    }
+    STATS_COUNT(COUNTER_MOVES_ATTEMPTED, turns);
+    STATS_COUNT(COUNTER_MOVES_BLOCKED, blocked);
+    STATS_COUNT(COUNTER_MOVES_CONTESTED, contested);
+
+    int words = game -> map -> words;
+    if (moved > words / 8) {
+        if (game -> pool != NULL && words > ZOMBIE_CHUNK) {
+            runPool(game -> pool, (words + ZOMBIE_CHUNK - 1) / ZOMBIE_CHUNK, buildLegalChunk, game);
+        }
+        else {
+            buildLegalMoves(game, 0, words);
+        }
+        return;
+    }
+    // Each refresh only looks at the final layout, so they can be done in any order
+    for (int turn = 0; turn < turns && moved > 0; turn++) {
+        int i = turnZombie(game, turn);
+        enum Direction direction = game -> moves[i];
+        if (direction != DIRECTION_NONE) {
+            int to = actorCell(game, &game -> zombies[i]);
+            refreshLegalMoves(game, to - offsets[direction], to);
+            moved--;
+        }
+    }
+}
+
+static void buildLegalChunk(void* game, int chunk) {
+    int first = chunk * ZOMBIE_CHUNK;
+    int last = first + ZOMBIE_CHUNK;
+    if (last > ((struct Game*)game) -> map -> words) {
+        last = ((struct Game*)game) -> map -> words;
+    }
+    buildLegalMoves(game, first, last);
+}
+
+static void proposeChunk(void* game, int chunk) {
+    int turns = ((struct Game*)game) -> levelOfDetail ? ((struct Game*)game) -> numDetailed : ((struct Game*)game) -> numZombies;
+    int first = chunk * ZOMBIE_CHUNK;
+    int last = first + ZOMBIE_CHUNK;
+    if (last > turns) {
+        last = turns;
+    }
+    proposeMoves(game, first, last);
+}
+
+/*
+    Aggressive zombies follow the flow field: every step that lowers their walking distance to the player is
+    on a shortest path around the walls. Of those, the step along the axis the player is further away on is
+    tried first, the way zombies always lined up on the player, and the other one if a zombie is in the way.
+    The flow field must be up to date.
+*/
+static enum Direction aggressiveStep(const struct Game* game, const struct Actor* Zombie) {
+    const struct Actor* Player = &game -> Player;
+    int cell = actorCell(game, Zombie);
+    int distance = distanceToPlayer(game, cell);
+
+    if (distance == 0 || (distance == UNREACHABLE && game -> fieldComplete)) {
+        // The Zombie already has the player, or is walled off from them, so it stays put
+        return DIRECTION_NONE;
+    }
+
+    int dx = Player -> xcoord - Zombie -> xcoord;
+    int dy = Player -> ycoord - Zombie -> ycoord;
+    enum Direction horizontal = dx < 0 ? DIRECTION_LEFT : DIRECTION_RIGHT;
+    enum Direction vertical = dy < 0 ? DIRECTION_UP : DIRECTION_DOWN;
+    enum Direction order[4];
+    if (abs(dx) > abs(dy)) {
+        order[0] = horizontal;
+        order[1] = vertical;
+    }
+    else {
+        order[0] = vertical;
+        order[1] = horizontal;
+    }
+    // Going the "wrong" way is sometimes the only way around a wall
+    order[2] = (order[1] + 2) % 4;
+    order[3] = (order[0] + 2) % 4;
+
+    if (distance == UNREACHABLE) {
+        // Too far away for the flow field, so head straight for the player and hope for the best
+        for (int i = 0; i < 2; i++) {
+            if (testBit(game -> legalMoves[order[i]], cell)) {
+                return order[i];
+            }
+        }
+        return DIRECTION_NONE;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (distanceToPlayer(game, cell + game -> map -> offsets[order[i]]) == distance - 1 && testBit(game -> legalMoves[order[i]], cell)) {
+            return order[i];
+        }
+    }
+    return DIRECTION_NONE;
+}
+
+static enum Direction passiveStep(const struct Game* game, int zombie) {
+    enum Direction direction = randomDirection(zombieRandom(game -> roundKey, (unsigned int)game -> ticks, zombie));
+    return testBit(game -> legalMoves[direction], actorCell(game, &game -> zombies[zombie])) ? direction : DIRECTION_NONE;
+}
+
+void AggressiveZombieMotion(struct Game* game, struct Actor* Zombie) {
+    refreshFlowField(game);
+    enum Direction direction = aggressiveStep(game, Zombie);
+    if (direction != DIRECTION_NONE) {
+        moveZombie(game, Zombie, direction);
+    }
+}
+
+void randomPassiveZombieMotion(struct Game* game, struct Actor* Zombie) {
+    enum Direction direction = passiveStep(game, (int)(Zombie - game -> zombies));
+    if (direction != DIRECTION_NONE) {
+        moveZombie(game, Zombie, direction);
+    }
+}
+
+char moveZombieLeft(struct Game* game, struct Actor* Zombie) {
+    return moveZombie(game, Zombie, DIRECTION_LEFT);
+}
+
+char moveZombieRight(struct Game* game, struct Actor* Zombie) {
+    return moveZombie(game, Zombie, DIRECTION_RIGHT);
+}
+
+char moveZombieUp(struct Game* game, struct Actor* Zombie) {
+    return moveZombie(game, Zombie, DIRECTION_UP);
+}
+
+char moveZombieDown(struct Game* game, struct Actor* Zombie) {
+    return moveZombie(game, Zombie, DIRECTION_DOWN);
+}
+
+char moveZombie(struct Game* game, struct Actor* Zombie, enum Direction direction) {
+    int from = actorCell(game, Zombie);
+    STATS_COUNT(COUNTER_MOVES_ATTEMPTED, 1);
+    if (direction == DIRECTION_NONE || !testBit(game -> legalMoves[direction], from)) {
+        STATS_COUNT(COUNTER_MOVES_BLOCKED, 1);
+        return 0;
+    }
+
+    // The Zombie is moving to a valid tile
+    int to = from + game -> map -> offsets[direction];
+    clearBit(game -> zombieBits, from);
+    setBit(game -> zombieBits, to);
+    Zombie -> xcoord += directionX[direction];
+    Zombie -> ycoord += directionY[direction];
+    refreshLegalMoves(game, from, to);
+    game -> regionsFiled = 0;
+    return 1;
+}
+
+/*
+    Zombies can step onto any floor tile without a zombie on it, so for each direction the legal moves are
+    the zombie layer ANDed with the open floor layer shifted one step back the other way. This works out
+    a whole 64 bit word at once, for every zombie in it, for the words from first up to last.
+    The wall padding around the map keeps shifts from wrapping onto the neighbouring row.
+*/
+static void buildLegalMoves(struct Game* game, int first, int last) {
+    const struct Map* map = game -> map;
+
+    for (int word = first; word < last; word++) {
+        for (int direction = 0; direction < 4; direction++) {
+            // Bit i of shifted is whether the cell offset steps on from bit i of this word is open
+            int offset = map -> offsets[direction];
+            int source = (word * 64 + offset) >> 6;
+            int bits = (word * 64 + offset) & 63;
+            unsigned long long low = 0;
+            unsigned long long high = 0;
+            if (source >= 0 && source < map -> words) {
+                low = map -> floorBits[source] & ~game -> zombieBits[source];
+            }
+            if (source + 1 >= 0 && source + 1 < map -> words) {
+                high = map -> floorBits[source + 1] & ~game -> zombieBits[source + 1];
+            }
+            unsigned long long shifted = bits == 0 ? low : (low >> bits) | (high << (64 - bits));
+            game -> legalMoves[direction][word] = game -> zombieBits[word] & shifted;
+        }
+    }
+}
+
+/*
+    A zombie stepping from one cell to another only changes what is legal for itself and for the zombies
+    right next to the two cells, so after a move just those bits are worked out again.
+*/
+static void refreshLegalMoves(struct Game* game, int from, int to) {
+    unsigned char open = game -> map -> openDirections[to];
+
+    for (int direction = 0; direction < 4; direction++) {
+        int offset = game -> map -> offsets[direction];
+        unsigned long long* legal = game -> legalMoves[direction];
+
+        // The zombie has left, and anyone one step behind from in this direction may now walk in
+        clearBit(legal, from);
+        if (testBit(game -> zombieBits, from - offset)) {
+            setBit(legal, from - offset);
+        }
+
+        // Nobody else can walk into the zombie's new cell
+        clearBit(legal, to - offset);
+
+        // And the zombie itself can go on to any open floor around it
+        if ((open & (1 << direction)) && !testBit(game -> zombieBits, to + offset)) {
+            setBit(legal, to);
+        }
+        else {
+            clearBit(legal, to);
+        }
+    }
+}
+
+// Whether a cell has a zombie on it matters to the legal moves of that zombie and of the four next to it
+static void rebuildLegalAround(struct Game* game, int cell) {
+    int stride = game -> map -> stride;
+    buildLegalMoves(game, (cell - 1) >> 6, ((cell + 1) >> 6) + 1);
+    buildLegalMoves(game, (cell - stride) >> 6, ((cell - stride) >> 6) + 1);
+    buildLegalMoves(game, (cell + stride) >> 6, ((cell + stride) >> 6) + 1);
+}
+
+/*
+    Walking distance from source to every floor cell within radius steps, by breadth first search. The cells
+    reached are listed in fieldCells so the next rebuild only has to wipe those.
+    If nothing was cut off by the radius the field covers everywhere the player can be reached from.
+*/
+static void rebuildFlowField(struct Game* game, int source, int radius) {
+    const struct Map* map = game -> map;
+    int* distances = game -> distances;
+    int* cells = game -> fieldCells;
+
+    STATS_COUNT(COUNTER_FLOW_REBUILDS, 1);
+    for (int i = 0; i < game -> fieldSize; i++) {
+        distances[cells[i]] = 0;
+    }
+    game -> distanceBase = 0;
+    game -> fieldSource = source;
+    game -> fieldComplete = 1;
+    game -> fieldRestored = 0;
+    game -> fieldUndoLength = 0;
+    distances[source] = FIELD_ZERO;
+    cells[0] = source;
+
+    int head = 0;
+    int tail = 1;
+    while (head < tail) {
+        int cell = cells[head++];
+        unsigned char open = map -> openDirections[cell];
+        for (int direction = 0; direction < 4; direction++) {
+            int next = cell + map -> offsets[direction];
+            if ((open & (1 << direction)) && distances[next] == 0) {
+                if (distances[cell] - FIELD_ZERO == radius) {
+                    game -> fieldComplete = 0;
+                    continue;
+                }
+                distances[next] = distances[cell] + 1;
+                cells[tail++] = next;
+            }
+        }
+    }
+    game -> fieldSize = tail;
+}
+
+/*
+    Moves the flow field one step of the player's, from fieldSource to the neighbouring cell source.
+    Every distance changes by exactly one (the grid is bipartite, so the parity of every distance flips).
+    Cells whose shortest path ran through source get one closer and everything else one further. Rather than
+    rewriting every cell, distanceBase is raised by one for everyone, and only the cells that got closer are
+    walked, downstream from source, and lowered by two.
+*/
+static void stepFlowField(struct Game* game, int source) {
+    int* queue = game -> fieldQueue;
+    int* distances = game -> distances;
+    int stride = game -> map -> stride;
+    int head = 0;
+    int tail = 0;
+
+    STATS_COUNT(COUNTER_FLOW_STEPS, 1);
+    game -> fieldUndoFrom = game -> fieldSource;
+    game -> distanceBase++;
+    game -> fieldSource = source;
+    distances[source] -= 2;
+    queue[tail++] = source;
+
+    while (head < tail) {
+        int cell = queue[head++];
+        int further = distances[cell] + 3;
+        // Before this step a downstream cell was one further than cell. If it hasn't been lowered yet it now
+        // reads three more than cell's new distance, and once lowered it reads one more, so it is queued only once.
+        // Walls and cells outside the field read 0 and never match.
+        int next[4] = {cell - stride, cell - 1, cell + stride, cell + 1};
+        for (int direction = 0; direction < 4; direction++) {
+            if (distances[next[direction]] == further) {
+                distances[next[direction]] -= 2;
+                queue[tail++] = next[direction];
+            }
+        }
+    }
+    game -> fieldUndoLength = tail;
+}
+
+// Takes back the field's last step, raising the cells it lowered, which are still at the front of the queue
+static void unstepFlowField(struct Game* game) {
+    for (int i = 0; i < game -> fieldUndoLength; i++) {
+        game -> distances[game -> fieldQueue[i]] += 2;
+    }
+    game -> distanceBase--;
+    game -> fieldSource = game -> fieldUndoFrom;
+    game -> fieldUndoLength = 0;
+}
+
+/*
+    Brings back the field a restored snapshot had. A complete field holds the true walking distance to every
+    cell the player can be reached from, so it is searched again from its source with no radius (which can't
+    find more cells than fit, as they are the same cells) and shifted to the snapshot's distanceBase.
+    A cut off field is searched again from its source, out to FLOW_RADIUS as it was.
+*/
+static void recoverFlowField(struct Game* game) {
+    int distanceBase = game -> distanceBase;
+    if (!game -> fieldComplete) {
+        rebuildFlowField(game, game -> fieldSource, FLOW_RADIUS);
+        return;
+    }
+    rebuildFlowField(game, game -> fieldSource, INT_MAX);
+    for (int i = 0; i < game -> fieldSize; i++) {
+        game -> distances[game -> fieldCells[i]] -= distanceBase;
+    }
+    game -> distanceBase = distanceBase;
+}
+
+/*
+    The flow field is brought up to date only when an aggressive zombie needs it. A complete field catches up
+    on the player's steps since one at a time, unless there were so many that starting over is cheaper, and
+    comes out exactly as if it had been searched from the player's cell. A field cut off by FLOW_RADIUS
+    wouldn't: stepping it keeps the far edge where it was searched, so what zombies did would depend on where
+    the player had been, not just where everyone stands. It is searched again around the player instead.
+*/
+static void updateFlowField(struct Game* game) {
+    if (game -> fieldPathLength > FLOW_PATH_MAX || game -> distanceBase > (1 << 29)
+        || (!game -> fieldComplete && game -> fieldPathLength > 0)) {
+        rebuildFlowField(game, actorCell(game, &game -> Player), FLOW_RADIUS);
+    }
+    else {
+        if (game -> fieldRestored) {
+            recoverFlowField(game);
+        }
+        for (int i = 0; i < game -> fieldPathLength; i++) {
+            stepFlowField(game, game -> fieldPath[i]);
+        }
+    }
+    game -> fieldPathLength = 0;
+}
+
+void refreshFlowField(struct Game* game) {
+    if (game -> fieldPathLength != 0 || game -> fieldRestored) {
+        updateFlowField(game);
+    }
+}
+
+unsigned int nextRandom(unsigned long long* state) {
+    unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
@@ -0,0 +1,216 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stddef.h>
+
+#include "map.h"
+#include "pool.h"
+
+// Player steps the flow field will catch up on one by one before it is cheaper to rebuild it
+#define FLOW_PATH_MAX 4
+// How many steps from the player the flow field reaches; zombies further out steer straight at the player
+#define FLOW_RADIUS 32
+// Zombies are handed to a game's thread pool in chunks of this size
+#define ZOMBIE_CHUNK 2048
+// With levelOfDetail, zombies this many rows and columns from the player move every tick,
+// those up to LOD_MID away every LOD_MID_PERIOD ticks, and the rest change regions every LOD_FAR_PERIOD
+#define LOD_NEAR 16
+#define LOD_MID 48
+#define LOD_MID_PERIOD 4
+#define LOD_FAR_PERIOD 64
+
+enum ActorKind {
+    ACTOR_NOTHING,
+    ACTOR_PLAYER,
+    ACTOR_ZOMBIE,
+    ACTOR_ESCAPE
+};
+
+// Which way the player last moved, which picks the player's icon
+enum Facing {
+    FACING_NONE,
+    FACING_UP,
+    FACING_LEFT,
+    FACING_DOWN,
+    FACING_RIGHT
+};
+
+/*
+    Actors are anything that are "interactable".
+    Players, Zombies, stairs, and examinable items are examples.
+*/
+struct Actor {
+    unsigned char kind;
+    unsigned char facing;
+    short xcoord;
+    short ycoord;
+    short startingX;
+    short startingY;
+};
+
+enum GameOutcome {
+    GAME_RUNNING,
+    GAME_ESCAPED,
+    GAME_DIED
+};
+
+/*
+    Everything about a round that changes as it is played, in one flat block with no pointers in it, so it can
+    be copied with memcpy, kept in arrays or written to a file as it is. A snapshot is snapshotSize bytes long,
+    a few hundred for the office, and only fits games of the same map and horde.
+
+    The flow field itself isn't kept, only how to get it back: the cell it reads distances to, and the steps
+    the player took since (see restoreGame).
+*/
+struct GameSnapshot {
+    unsigned long ticks;
+    unsigned long long rngState;
+    unsigned int roundKey;
+    char playerDied;
+    char playerBlocked;
+    unsigned char playerFacing;
+    char fieldComplete;
+    int fieldSource;
+    int distanceBase;
+    int fieldPathLength;
+    int fieldPath[FLOW_PATH_MAX];
+    int numZombies;
+    struct Spawn player;
+    struct Spawn zombies[];
+};
+
+/*
+    A Game holds everything one round of Zombies In The Office needs, including its own random number state,
+    so any number of games can be simulated side by side without sharing anything but their Map.
+
+    Besides the map's floor, the game keeps bitboards of who stands where, in the map's cell layout.
+    legalMoves[d] has a bit set on every zombie that could step in direction d right now. It is built for all
+    zombies at once with shifts and masks, and kept up to date as zombies move.
+
+    distances is the flow field that aggressive zombies follow: the walking distance from every floor cell to
+    fieldSource is distances[cell] + distanceBase - FIELD_ZERO, for the fieldSize cells listed in fieldCells,
+    and every other cell reads 0. fieldComplete says whether that is every cell the player can be reached
+    from, or the search stopped at FLOW_RADIUS. Either way the field depends on fieldSource alone, never on
+    where the player was before, so where everyone stands decides every zombie's step. fieldPath holds the
+    cells the player has stepped to since, which are caught up on the next time an aggressive zombie looks.
+    A length past FLOW_PATH_MAX means the field has to be built from scratch, and fieldRestored that
+    distances doesn't match the rest yet, because the game was restored from a snapshot. The last step the
+    field took is kept as the cell it was taken from and the fieldUndoLength cells it lowered, left at the
+    front of fieldQueue, so a game restored to just before that step takes it back instead of searching
+    again (0 when there is none).
+
+    Every layer the size of the map reads 0 where nothing is, so a new game's layers come straight from
+    calloc: on a big map the pages nobody stands near are never touched, and stay the kernel's shared zero
+    page, copied only once something is written to them.
+
+    Zombies move in two phases each tick. First every zombie picks its step into moves[] looking only at where
+    everyone stood when the tick began, so the zombies can be split over pool's threads in any order. Then the
+    steps are taken in zombie order: a zombie whose cell was taken a moment ago by a lower numbered zombie
+    stays put. Random choices come from roundKey, the tick and the zombie's number rather than a shared
+    stream, so a game plays out the same on any number of threads.
+*/
+struct Game {
+    const struct Map* map;
+    unsigned long long* zombieBits;
+    unsigned long long* playerBits;
+    unsigned long long* legalMoves[4];
+    int* distances;
+    int distanceBase;
+    int fieldSource;
+    int* fieldCells;
+    int fieldSize;
+    char fieldComplete;
+    int* fieldQueue;
+    int fieldUndoFrom;
+    int fieldUndoLength;
+    int fieldPath[FLOW_PATH_MAX];
+    int fieldPathLength;
+    char fieldRestored;
+    struct Actor Player;
+    struct Actor Escape;
+    int numZombies;
+    struct Actor* zombies;
+    unsigned char* moves;
+    // Optional, owned by the caller. Without one, or with a small horde, zombies are all moved on the calling thread.
+    struct Pool* pool;
+    /*
+        Optional level of detail for big hordes on big maps, off unless the caller turns it on. Zombies after
+        the player or within LOD_NEAR move every tick as usual, those within LOD_MID once every LOD_MID_PERIOD
+        ticks, and the rest only wander from region to region of the map. Everyone stays on a real tile, so a
+        zombie coming into range carries on from where it is. Games still play out the same every time, on
+        any number of threads, but not the same as they would without it.
+    */
+    char levelOfDetail;
+    /*
+        What levelOfDetail keeps so a tick needn't look at the whole horde. Every zombie is filed under the map
+        region it stands in, zombieRegion, in a list that starts at regionFirst and runs through regionNext and
+        regionPrevious to -1. The lists are only kept while regionsFiled is set; anything that moves zombies
+        outside a detailed tick clears it, and the next one files everybody again. Each tick the zombies of the
+        regions around the player, or level with them, that are due a step are marked in detailedBits, then
+        listed in order in detailed, and only those numDetailed zombies pick one.
+    */
+    int* regionFirst;
+    int* regionNext;
+    int* regionPrevious;
+    int* zombieRegion;
+    char regionsFiled;
+    unsigned long long* detailedBits;
+    int* detailed;
+    int numDetailed;
+    char playerDied;
+    // Set by stepGame when the player tried to walk into a wall
+    char playerBlocked;
+    unsigned long long rngState;
+    // Drawn from rngState at every reset, so each round plays differently
+    unsigned int roundKey;
+    unsigned long ticks;
+    // Where every round starts, which resetGame restores
+    struct GameSnapshot* start;
+};
+
+/*
+    numZombies is the size of the horde. The first ones start on the map's zombie spawns and the rest on
+    floor tiles picked with the seed, away from the player. The map must outlive the game.
+*/
+struct Game* createGame(const struct Map*, unsigned long long seed, int numZombies);
+void destroyGame(struct Game*);
+void seedGame(struct Game*, unsigned long long seed);
+void resetGame(struct Game*);
+/*
+    Puts the player and every zombie (zombies[i] for zombie i, or their starting tiles if zombies is NULL) on
+    the given tiles at the given tick, alive, as if the round had played out to there. The tiles must be free
+    floor, with no two zombies on the same one.
+*/
+void placeActors(struct Game*, struct Spawn player, const struct Spawn* zombies, unsigned long ticks);
+
+size_t snapshotSize(const struct Game*);
+void saveGame(const struct Game*, struct GameSnapshot*);
+/*
+    Puts the game back the way it was when the snapshot was saved, so it plays on exactly as that game would
+    have. Only the actors that moved since are taken off and put back, and the flow field is searched again
+    around its source the next time a zombie needs it, unless it is already the one the snapshot had
+    or one step of the player's past it.
+*/
+void restoreGame(struct Game*, const struct GameSnapshot*);
+// Brings the flow field up to date now, rather than the next time an aggressive zombie needs it
+void refreshFlowField(struct Game*);
+// A new game on the same map, in the same state, that plays on on its own from here. NULL when out of memory.
+struct Game* forkGame(const struct Game*);
+enum GameOutcome stepGame(struct Game*, char input);
+enum GameOutcome gameOutcome(const struct Game*);
+// The two character icon to draw for a cell, which is its occupant if there is one and the tile otherwise
+const char* cellIcon(const struct Game*, int row, int column);
+
+char moveZombieLeft(struct Game*, struct Actor*);
+char moveZombieRight(struct Game*, struct Actor*);
+char moveZombieUp(struct Game*, struct Actor*);
+char moveZombieDown(struct Game*, struct Actor*);
+char moveZombie(struct Game*, struct Actor*, enum Direction);
+// These move one zombie straight away, on its own; stepGame moves the whole horde in two phases instead
+void AggressiveZombieMotion(struct Game*, struct Actor*);
+void randomPassiveZombieMotion(struct Game*, struct Actor*);
+
+// Small, fast generator (splitmix64) used for everything random, so no game touches the global rand() state
+unsigned int nextRandom(unsigned long long* state);
+
+#endif
@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "map.h"
+
+static void setFloor(unsigned char* tiles, unsigned long long* floorBits, int cell);
+static unsigned char* buildOpenDirections(const struct Map*);
+static unsigned char* buildRegionOpen(struct Map*);
+
+struct Map* loadMap(const char* path, char* error, int errorSize) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        snprintf(error, errorSize, "Can't open map %s.", path);
+        return NULL;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        snprintf(error, errorSize, "Map %s is empty.", path);
+        close(fd);
+        return NULL;
+    }
+
+    const char* text = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        snprintf(error, errorSize, "Can't read map %s.", path);
+        return NULL;
+    }
+
+    // The layout is read straight out of the mapping and only the tiles it describes are kept
+    posix_madvise((void*)text, status.st_size, POSIX_MADV_SEQUENTIAL);
+    struct Map* map = parseMap(text, status.st_size, error, errorSize);
+    munmap((void*)text, status.st_size);
+    return map;
+}
+
+struct Map* parseMap(const char* text, long length, char* error, int errorSize) {
+    // First pass: how big is the floor?
+    int rows = 0;
+    int columns = 0;
+    long lineStart = 0;
+    for (long i = 0; i <= length; i++) {
+        if (i == length || text[i] == '\n') {
+            long width = i - lineStart;
+            if (width > 0 && text[i - 1] == '\r') {
+                width--;
+            }
+            // A newline at the very end doesn't start another row
+            if (i < length || width > 0) {
+                rows++;
+            }
+            if (width > columns) {
+                columns = width > MAP_MAX_SIDE ? MAP_MAX_SIDE + 1 : (int)width;
+            }
+            lineStart = i + 1;
+        }
+    }
+    if (rows == 0 || columns == 0) {
+        snprintf(error, errorSize, "The map has no tiles.");
+        return NULL;
+    }
+    if (rows > MAP_MAX_SIDE || columns > MAP_MAX_SIDE) {
+        snprintf(error, errorSize, "Maps can be at most %d by %d tiles.", MAP_MAX_SIDE, MAP_MAX_SIDE);
+        return NULL;
+    }
+
+    struct Map* map = calloc(1, sizeof(struct Map));
+    if (map == NULL) {
+        snprintf(error, errorSize, "Not enough memory for the map.");
+        return NULL;
+    }
+    map -> rows = rows;
+    map -> columns = columns;
+    map -> stride = columns + 1;
+    map -> cells = (rows + 2) * map -> stride;
+    map -> words = (map -> cells + 63) / 64;
+    map -> offsets[DIRECTION_UP] = -map -> stride;
+    map -> offsets[DIRECTION_LEFT] = -1;
+    map -> offsets[DIRECTION_DOWN] = map -> stride;
+    map -> offsets[DIRECTION_RIGHT] = 1;
+    map -> playerSpawn.xcoord = -1;
+    map -> escapeSpawn.xcoord = -1;
+
+    // Everything starts out as wall, including the padding, and the floor is carved out of it
+    unsigned char* tiles = malloc(map -> cells);
+    unsigned long long* floorBits = calloc(map -> words, sizeof(unsigned long long));
+    struct Spawn* zombieSpawns = NULL;
+    map -> tiles = tiles;
+    map -> floorBits = floorBits;
+    if (tiles == NULL || floorBits == NULL) {
+        snprintf(error, errorSize, "Not enough memory for the map.");
+        destroyMap(map);
+        return NULL;
+    }
+    memset(tiles, TILE_JWALL, map -> cells);
+
+    // Second pass: read the tiles
+    int capacity = 0;
+    int row = 0;
+    int column = 0;
+    for (long i = 0; i < length; i++) {
+        char c = text[i];
+        if (c == '\n') {
+            row++;
+            column = 0;
+            continue;
+        }
+        if (c == '\r' && (i + 1 == length || text[i + 1] == '\n')) {
+            continue;
+        }
+
+        int cell = cellIndex(map, row, column);
+        switch (c) {
+        case ' ':
+        case '.':
+            setFloor(tiles, floorBits, cell);
+            break;
+        case '-':
+            tiles[cell] = TILE_HWALL;
+            break;
+        case '|':
+            tiles[cell] = TILE_VWALL;
+            break;
+        case '+':
+        case '#':
+            tiles[cell] = TILE_JWALL;
+            break;
+        case 'P':
+        case 'E':
+            if ((c == 'P' ? map -> playerSpawn : map -> escapeSpawn).xcoord != -1) {
+                snprintf(error, errorSize, "The map has more than one '%c' (row %d, column %d).", c, row + 1, column + 1);
+                destroyMap(map);
+                return NULL;
+            }
+            setFloor(tiles, floorBits, cell);
+            if (c == 'P') {
+                map -> playerSpawn.xcoord = column;
+                map -> playerSpawn.ycoord = row;
+            }
+            else {
+                map -> escapeSpawn.xcoord = column;
+                map -> escapeSpawn.ycoord = row;
+            }
+            break;
+        case 'Z':
+            setFloor(tiles, floorBits, cell);
+            if (map -> numZombieSpawns == capacity) {
+                capacity = capacity == 0 ? 16 : capacity * 2;
+                struct Spawn* grown = realloc(zombieSpawns, capacity * sizeof(struct Spawn));
+                if (grown == NULL) {
+                    snprintf(error, errorSize, "Not enough memory for the map.");
+                    destroyMap(map);
+                    return NULL;
+                }
+                zombieSpawns = grown;
+                map -> zombieSpawns = grown;
+            }
+            zombieSpawns[map -> numZombieSpawns].xcoord = column;
+            zombieSpawns[map -> numZombieSpawns].ycoord = row;
+            map -> numZombieSpawns++;
+            break;
+        default:
+            snprintf(error, errorSize, "Unknown tile '%c' at row %d, column %d of the map.", c, row + 1, column + 1);
+            destroyMap(map);
+            return NULL;
+        }
+        column++;
+    }
+
+    if (map -> playerSpawn.xcoord == -1 || map -> escapeSpawn.xcoord == -1) {
+        snprintf(error, errorSize, "The map needs a 'P' for the player and an 'E' for the escape door.");
+        destroyMap(map);
+        return NULL;
+    }
+    map -> openDirections = buildOpenDirections(map);
+    map -> regionOpen = map -> openDirections != NULL ? buildRegionOpen(map) : NULL;
+    if (map -> regionOpen == NULL) {
+        snprintf(error, errorSize, "Not enough memory for the map.");
+        destroyMap(map);
+        return NULL;
+    }
+    return map;
+}
+
+void destroyMap(struct Map* map) {
+    if (map == NULL || map -> builtIn) {
+        return;
+    }
+    free((void*)map -> tiles);
+    free((void*)map -> floorBits);
+    free((void*)map -> openDirections);
+    free((void*)map -> regionOpen);
+    free((void*)map -> zombieSpawns);
+    free(map);
+}
+
+/*
+    FNV-1a over the size, tiles and spawns of the map, so a replay can tell whether it is being played back on
+    the floor it was recorded on.
+*/
+unsigned long long mapChecksum(const struct Map* map) {
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    int header[5] = {map -> rows, map -> columns, map -> numZombieSpawns, map -> playerSpawn.xcoord * 65536 + map -> playerSpawn.ycoord,
+        map -> escapeSpawn.xcoord * 65536 + map -> escapeSpawn.ycoord};
+    const unsigned char* bytes = (const unsigned char*)header;
+    for (size_t i = 0; i < sizeof(header); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    for (int i = 0; i < map -> cells; i++) {
+        hash = (hash ^ map -> tiles[i]) * 0x100000001B3ULL;
+    }
+    for (int i = 0; i < map -> numZombieSpawns; i++) {
+        hash = (hash ^ (unsigned short)map -> zombieSpawns[i].xcoord) * 0x100000001B3ULL;
+        hash = (hash ^ (unsigned short)map -> zombieSpawns[i].ycoord) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static void setFloor(unsigned char* tiles, unsigned long long* floorBits, int cell) {
+    tiles[cell] = TILE_FLOOR;
+    floorBits[cell >> 6] |= 1ULL << (cell & 63);
+}
+
+// Which of the four steps from each cell land on floor; steps off the padding are never open
+static unsigned char* buildOpenDirections(const struct Map* map) {
+    unsigned char* open = calloc(map -> cells, 1);
+    if (open == NULL) {
+        return NULL;
+    }
+    for (int cell = 0; cell < map -> cells; cell++) {
+        for (int direction = 0; direction < 4; direction++) {
+            int next = cell + map -> offsets[direction];
+            if (next >= 0 && next < map -> cells && (map -> floorBits[next >> 6] >> (next & 63) & 1)) {
+                open[cell] |= 1 << direction;
+            }
+        }
+    }
+    return open;
+}
+
+// Which sides of each region floor crosses, found from the steps right and down out of every cell on its edge
+static unsigned char* buildRegionOpen(struct Map* map) {
+    map -> regionRows = (map -> rows + MAP_REGION_SIDE - 1) / MAP_REGION_SIDE;
+    map -> regionColumns = (map -> columns + MAP_REGION_SIDE - 1) / MAP_REGION_SIDE;
+    unsigned char* open = calloc((size_t)map -> regionRows * map -> regionColumns, 1);
+    if (open == NULL) {
+        return NULL;
+    }
+    for (int row = 0; row < map -> rows; row++) {
+        for (int column = 0; column < map -> columns; column++) {
+            int region = row / MAP_REGION_SIDE * map -> regionColumns + column / MAP_REGION_SIDE;
+            unsigned char steps = map -> openDirections[cellIndex(map, row, column)];
+            if (column % MAP_REGION_SIDE == MAP_REGION_SIDE - 1 && (steps & (1 << DIRECTION_RIGHT))) {
+                open[region] |= 1 << DIRECTION_RIGHT;
+                open[region + 1] |= 1 << DIRECTION_LEFT;
+            }
+            if (row % MAP_REGION_SIDE == MAP_REGION_SIDE - 1 && (steps & (1 << DIRECTION_DOWN))) {
+                open[region] |= 1 << DIRECTION_DOWN;
+                open[region + map -> regionColumns] |= 1 << DIRECTION_UP;
+            }
+        }
+    }
+    return open;
+}
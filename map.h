@@ -0,0 +1,87 @@
+#ifndef MAP_H
+#define MAP_H
+
+// Largest number of rows or columns a map file may have
+#define MAP_MAX_SIDE 16384
+// Side of the square regions far away zombies wander between (see levelOfDetail in game.h)
+#define MAP_REGION_SIDE 16
+
+enum TileKind {
+    TILE_FLOOR,
+    TILE_HWALL,
+    TILE_VWALL,
+    TILE_JWALL
+};
+
+enum Direction {
+    DIRECTION_UP,
+    DIRECTION_LEFT,
+    DIRECTION_DOWN,
+    DIRECTION_RIGHT,
+    // Not a step at all, for a zombie that stays where it is
+    DIRECTION_NONE
+};
+
+struct Spawn {
+    short xcoord;
+    short ycoord;
+};
+
+/*
+    A Map is the fixed layout of a floor: its tiles and where everyone starts.
+    It never changes once loaded, so any number of games, on any number of threads, can share one.
+
+    Cells are laid out row by row with one extra wall column on the right of every row and an extra wall
+    row above and below the map, so a step off any edge lands on a wall without needing a bounds check.
+    tiles holds a tile kind per cell and floorBits a bit per cell that is floor, both in that layout.
+    openDirections holds a bit per direction (1 << DIRECTION_UP and so on) for each cell, set when the cell a
+    step that way is floor, so whether a step is possible is one lookup and where it lands is cell + offsets[d].
+    The map is also cut into MAP_REGION_SIDE squares, regionColumns across and regionRows down, and
+    regionOpen holds a bit per direction for each, set when floor crosses into the next region that way.
+*/
+struct Map {
+    int rows;
+    int columns;
+    int stride;
+    int cells;
+    // Number of 64 bit words in one bitboard layer of the map
+    int words;
+    // How far a step in each direction moves through the cells
+    int offsets[4];
+    const unsigned char* tiles;
+    const unsigned long long* floorBits;
+    const unsigned char* openDirections;
+    int regionRows;
+    int regionColumns;
+    const unsigned char* regionOpen;
+    struct Spawn playerSpawn;
+    struct Spawn escapeSpawn;
+    int numZombieSpawns;
+    const struct Spawn* zombieSpawns;
+    // Set for a map compiled into the program (see office.c), whose tables destroyMap leaves alone
+    int builtIn;
+};
+
+/*
+    Map files are plain text, one line per row of the floor and one character per tile:
+        ' ' or '.'  floor
+        '-' '|' '+' horizontal, vertical and junction walls ('#' is a junction too)
+        'P'         the player's start
+        'Z'         a zombie's start
+        'E'         the escape door
+    Short lines are filled out with wall. The file is memory-mapped and read in place.
+    On failure NULL is returned and error is filled in.
+*/
+struct Map* loadMap(const char* path, char* error, int errorSize);
+struct Map* parseMap(const char* text, long length, char* error, int errorSize);
+// The office everyone knows, compiled into the game from maps/office.txt at build time (see mapgen.c)
+struct Map* createOfficeMap(void);
+void destroyMap(struct Map*);
+// Changes whenever the layout or spawns of the map do
+unsigned long long mapChecksum(const struct Map*);
+
+static inline int cellIndex(const struct Map* map, int row, int column) {
+    return (row + 1) * map -> stride + column;
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "map.h"
+
+/*
+    Compiles a map file into C: its tiles, floor bits, open directions, regions and spawns as static tables,
+    and a struct Map pointing at them, so a program can start on that map without parsing or allocating anything.
+    The build runs it on maps/office.txt for the office that is built into the game.
+
+        mapgen NAME INPUT OUTPUT
+
+    writes the tables to OUTPUT as nameTiles, nameFloorBits and so on, and the map itself as nameMap.
+*/
+
+static void writeBytes(FILE*, const char* name, const char* suffix, const unsigned char* bytes, int count);
+
+int main(int argc, char* argv[]) {
+    if (argc != 4) {
+        printf("usage: mapgen NAME INPUT OUTPUT\n");
+        return 1;
+    }
+    const char* name = argv[1];
+
+    char error[100];
+    struct Map* map = loadMap(argv[2], error, sizeof(error));
+    if (map == NULL) {
+        fprintf(stderr, "%s\n", error);
+        return 1;
+    }
+    FILE* out = fopen(argv[3], "w");
+    if (out == NULL) {
+        fprintf(stderr, "Can't write %s.\n", argv[3]);
+        destroyMap(map);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by mapgen from %s; edit the map file, not this.\n\n", argv[2]);
+    writeBytes(out, name, "Tiles", map -> tiles, map -> cells);
+    writeBytes(out, name, "OpenDirections", map -> openDirections, map -> cells);
+    writeBytes(out, name, "RegionOpen", map -> regionOpen, map -> regionRows * map -> regionColumns);
+
+    fprintf(out, "static const unsigned long long %sFloorBits[%d] = {", name, map -> words);
+    for (int i = 0; i < map -> words; i++) {
+        fprintf(out, "%s0x%016llXULL,", i % 4 == 0 ? "\n    " : " ", map -> floorBits[i]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    // An empty initializer isn't C, so a map without zombie spawns still gets one unused entry
+    fprintf(out, "static const struct Spawn %sZombieSpawns[%d] = {", name, map -> numZombieSpawns > 0 ? map -> numZombieSpawns : 1);
+    for (int i = 0; i < map -> numZombieSpawns; i++) {
+        fprintf(out, "%s{%d, %d},", i % 8 == 0 ? "\n    " : " ", map -> zombieSpawns[i].xcoord, map -> zombieSpawns[i].ycoord);
+    }
+    fprintf(out, "%s\n};\n\n", map -> numZombieSpawns > 0 ? "" : "\n    {0, 0}");
+
+    fprintf(out, "static struct Map %sMap = {\n", name);
+    fprintf(out, "    .rows = %d,\n    .columns = %d,\n    .stride = %d,\n    .cells = %d,\n    .words = %d,\n",
+        map -> rows, map -> columns, map -> stride, map -> cells, map -> words);
+    fprintf(out, "    .offsets = {%d, %d, %d, %d},\n", map -> offsets[0], map -> offsets[1], map -> offsets[2], map -> offsets[3]);
+    fprintf(out, "    .tiles = %sTiles,\n    .floorBits = %sFloorBits,\n    .openDirections = %sOpenDirections,\n", name, name, name);
+    fprintf(out, "    .regionRows = %d,\n    .regionColumns = %d,\n    .regionOpen = %sRegionOpen,\n", map -> regionRows, map -> regionColumns, name);
+    fprintf(out, "    .playerSpawn = {%d, %d},\n    .escapeSpawn = {%d, %d},\n", map -> playerSpawn.xcoord, map -> playerSpawn.ycoord,
+        map -> escapeSpawn.xcoord, map -> escapeSpawn.ycoord);
+    fprintf(out, "    .numZombieSpawns = %d,\n    .zombieSpawns = %sZombieSpawns,\n    .builtIn = 1\n};\n", map -> numZombieSpawns, name);
+
+    int failed = ferror(out);
+    failed = fclose(out) != 0 || failed;
+    destroyMap(map);
+    if (failed) {
+        fprintf(stderr, "Can't write %s.\n", argv[3]);
+        remove(argv[3]);
+        return 1;
+    }
+    return 0;
+}
+
+static void writeBytes(FILE* out, const char* name, const char* suffix, const unsigned char* bytes, int count) {
+    fprintf(out, "static const unsigned char %s%s[%d] = {", name, suffix, count);
+    for (int i = 0; i < count; i++) {
+        fprintf(out, "%s%d,", i % 26 == 0 ? "\n    " : " ", bytes[i]);
+    }
+    fprintf(out, "\n};\n\n");
+}
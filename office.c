@@ -0,0 +1,9 @@
+#include "map.h"
+
+// Tables generated from maps/office.txt by mapgen when the game is built
+#include "office_map.h"
+
+// Nothing is parsed, copied or allocated: every game on the office shares these tables, and destroyMap leaves them be
+struct Map* createOfficeMap(void) {
+    return &officeMap;
+}
@@ -0,0 +1,157 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+/*
+    Workers sleep on wake until job is bumped, then take task indexes off next until they run out.
+    The last one to finish a task of the job signals done. active counts the workers still looking for
+    tasks, and a new job isn't set up until they have all stopped, so none of them can pick up a stale index.
+*/
+struct Pool {
+    int threads;
+    pthread_t* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long job;
+    int active;
+    char stopping;
+
+    void (*task)(void*, int);
+    void* context;
+    int count;
+    atomic_int next;
+    atomic_int remaining;
+};
+
+static void* runPoolWorker(void*);
+static void runTasks(struct Pool*);
+
+struct Pool* createPool(int threads) {
+    struct Pool* pool = calloc(1, sizeof(struct Pool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    pool -> workers = calloc(threads, sizeof(pthread_t));
+    if (pool -> workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool -> lock, NULL);
+    pthread_cond_init(&pool -> wake, NULL);
+    pthread_cond_init(&pool -> done, NULL);
+
+    // The caller is one of the threads, so only the others are started
+    pool -> threads = 1;
+    for (int i = 1; i < threads; i++) {
+        if (pthread_create(&pool -> workers[i], NULL, runPoolWorker, pool) != 0) {
+            break;
+        }
+        pool -> threads++;
+    }
+    return pool;
+}
+
+void destroyPool(struct Pool* pool) {
+    if (pool == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool -> lock);
+    pool -> stopping = 1;
+    pthread_cond_broadcast(&pool -> wake);
+    pthread_mutex_unlock(&pool -> lock);
+    for (int i = 1; i < pool -> threads; i++) {
+        pthread_join(pool -> workers[i], NULL);
+    }
+    pthread_cond_destroy(&pool -> done);
+    pthread_cond_destroy(&pool -> wake);
+    pthread_mutex_destroy(&pool -> lock);
+    free(pool -> workers);
+    free(pool);
+}
+
+int poolThreads(const struct Pool* pool) {
+    return pool -> threads;
+}
+
+void runPool(struct Pool* pool, int count, void (*task)(void*, int), void* context) {
+    if (count <= 0) {
+        return;
+    }
+    if (pool -> threads == 1 || count == 1) {
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool -> lock);
+    while (pool -> active > 0) {
+        pthread_cond_wait(&pool -> done, &pool -> lock);
+    }
+    pool -> task = task;
+    pool -> context = context;
+    pool -> count = count;
+    atomic_store(&pool -> next, 0);
+    atomic_store(&pool -> remaining, count);
+    pool -> job++;
+    pthread_cond_broadcast(&pool -> wake);
+    pthread_mutex_unlock(&pool -> lock);
+
+    runTasks(pool);
+
+    pthread_mutex_lock(&pool -> lock);
+    while (atomic_load(&pool -> remaining) > 0) {
+        pthread_cond_wait(&pool -> done, &pool -> lock);
+    }
+    pthread_mutex_unlock(&pool -> lock);
+}
+
+static void runTasks(struct Pool* pool) {
+    while (1) {
+        int index = atomic_fetch_add(&pool -> next, 1);
+        if (index >= pool -> count) {
+            return;
+        }
+        pool -> task(pool -> context, index);
+        if (atomic_fetch_sub(&pool -> remaining, 1) == 1) {
+            pthread_mutex_lock(&pool -> lock);
+            pthread_cond_signal(&pool -> done);
+            pthread_mutex_unlock(&pool -> lock);
+        }
+    }
+}
+
+static void* runPoolWorker(void* argument) {
+    struct Pool* pool = argument;
+    unsigned long seen = 0;
+
+    while (1) {
+        pthread_mutex_lock(&pool -> lock);
+        while (pool -> job == seen && !pool -> stopping) {
+            pthread_cond_wait(&pool -> wake, &pool -> lock);
+        }
+        if (pool -> stopping) {
+            pthread_mutex_unlock(&pool -> lock);
+            return NULL;
+        }
+        seen = pool -> job;
+        pool -> active++;
+        pthread_mutex_unlock(&pool -> lock);
+
+        runTasks(pool);
+
+        pthread_mutex_lock(&pool -> lock);
+        if (--pool -> active == 0) {
+            pthread_cond_signal(&pool -> done);
+        }
+        pthread_mutex_unlock(&pool -> lock);
+    }
+}
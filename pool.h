@@ -0,0 +1,22 @@
+#ifndef POOL_H
+#define POOL_H
+
+/*
+    A Pool is a set of worker threads kept around between jobs, so work can be spread over every core many
+    times a second without paying to start threads each time.
+*/
+struct Pool;
+
+// threads counts the caller too, so a pool of one runs everything on the calling thread. Returns NULL on failure.
+struct Pool* createPool(int threads);
+void destroyPool(struct Pool*);
+int poolThreads(const struct Pool*);
+
+/*
+    Calls task(context, index) for every index from 0 to count - 1, spread over the pool's threads and the
+    caller, and returns once they have all finished. Tasks may run in any order and on any thread.
+    Only one thread may run jobs on a pool at a time.
+*/
+void runPool(struct Pool*, int count, void (*task)(void* context, int index), void* context);
+
+#endif
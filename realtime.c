@@ -0,0 +1,225 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "realtime.h"
+#include "stats.h"
+
+// Keys the loop understands, besides w a s d themselves
+#define KEY_NONE 0
+#define KEY_QUIT 'q'
+
+static volatile sig_atomic_t stopRequested;
+
+static int waitForInput(long long nanoseconds);
+static int readKeys(char* key, unsigned long* coalesced);
+static void requestStop(int);
+
+void runRealtime(struct Game* game, struct Renderer* renderer, int tickMilliseconds, struct ReplayWriter* replay, struct RealtimeStats* stats) {
+    const struct Map* map = game -> map;
+    long long tickNanoseconds = (long long)(tickMilliseconds > 0 ? tickMilliseconds : 1) * 1000000;
+    memset(stats, 0, sizeof(struct RealtimeStats));
+
+    // Raw mode: keys arrive one at a time as they are pressed, without being echoed. Ctrl-C still interrupts.
+    struct termios saved;
+    int isTerminal = tcgetattr(STDIN_FILENO, &saved) == 0;
+    if (isTerminal) {
+        struct termios raw = saved;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+    stopRequested = 0;
+    struct sigaction action, savedAction;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, &savedAction);
+
+    const char* message = "Escape the office without getting eaten by hungry zombies! Use w a s d to move, q to quit.";
+    char pending = KEY_NONE;
+    long long firstKeyTime = 0;
+    long long nextTick = monotonicNanoseconds() + tickNanoseconds;
+    char running = 1;
+
+    renderFrame(renderer, game, viewStart(game -> Player.ycoord, map -> rows, renderer -> rows),
+        viewStart(game -> Player.xcoord, map -> columns, renderer -> columns), message);
+
+    while (running && !stopRequested) {
+        long long now = monotonicNanoseconds();
+
+        // Until the next tick is due, gather keys
+        if (now < nextTick) {
+            STATS_BEGIN(PHASE_INPUT_WAIT);
+            int ready = waitForInput(nextTick - now);
+            STATS_END(PHASE_INPUT_WAIT);
+            if (ready) {
+                char key = KEY_NONE;
+                int state = readKeys(&key, &stats -> coalescedKeys);
+                if (state < 0 || key == KEY_QUIT) {
+                    running = 0;
+                }
+                else if (state > 0 && strchr("wasd", key) != NULL) {
+                    // Only the last move of a tick is played; the latency is timed from the first
+                    if (pending == KEY_NONE) {
+                        firstKeyTime = monotonicNanoseconds();
+                    }
+                    else {
+                        stats -> coalescedKeys++;
+                    }
+                    pending = key;
+                }
+            }
+            continue;
+        }
+
+        long long jitter = now - nextTick;
+        stats -> jitterTotal += jitter;
+        if (jitter > stats -> jitterMax) {
+            stats -> jitterMax = jitter;
+        }
+        stats -> ticks++;
+
+        enum GameOutcome outcome = stepGame(game, pending);
+        if (replay != NULL) {
+            recordInput(replay, pending);
+        }
+        message = game -> playerBlocked ? "I can't go there." : "";
+        if (outcome == GAME_DIED) {
+            message = "You died! Want to play again? (y/n)";
+        }
+        else if (outcome == GAME_ESCAPED) {
+            message = "You escaped! Want to play again? (y/n)";
+        }
+        renderFrame(renderer, game, viewStart(game -> Player.ycoord, map -> rows, renderer -> rows),
+            viewStart(game -> Player.xcoord, map -> columns, renderer -> columns), message);
+
+        if (pending != KEY_NONE) {
+            long long latency = monotonicNanoseconds() - firstKeyTime;
+            stats -> inputs++;
+            stats -> latencyTotal += latency;
+            if (latency > stats -> latencyMax) {
+                stats -> latencyMax = latency;
+            }
+            pending = KEY_NONE;
+        }
+
+        // Ticks keep their slots on the timestep, but a loop that fell more than a tick behind skips the ones it
+        // missed rather than moving the zombies several times in a row to catch up
+        nextTick += tickNanoseconds;
+        if (now - nextTick > tickNanoseconds) {
+            long long behind = (now - nextTick) / tickNanoseconds;
+            stats -> skippedTicks += behind;
+            nextTick += behind * tickNanoseconds;
+        }
+
+        if (outcome != GAME_RUNNING) {
+            char answer = KEY_NONE;
+            while (answer != 'y' && answer != 'n' && answer != KEY_QUIT && !stopRequested) {
+                if (waitForInput(-1) && readKeys(&answer, &stats -> coalescedKeys) < 0) {
+                    break;
+                }
+            }
+            if (answer != 'y') {
+                break;
+            }
+            resetGame(game);
+            if (replay != NULL) {
+                recordReset(replay);
+            }
+            message = "Escape the office without getting eaten by hungry zombies! Use w a s d to move, q to quit.";
+            renderFrame(renderer, game, viewStart(game -> Player.ycoord, map -> rows, renderer -> rows),
+                viewStart(game -> Player.xcoord, map -> columns, renderer -> columns), message);
+            nextTick = monotonicNanoseconds() + tickNanoseconds;
+        }
+    }
+
+    sigaction(SIGINT, &savedAction, NULL);
+    if (isTerminal) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+    }
+}
+
+// Waits up to nanoseconds (forever if negative) for stdin to have something to read
+static int waitForInput(long long nanoseconds) {
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(STDIN_FILENO, &readable);
+    struct timespec timeout;
+    timeout.tv_sec = nanoseconds / 1000000000LL;
+    timeout.tv_nsec = nanoseconds % 1000000000LL;
+    return pselect(STDIN_FILENO + 1, &readable, NULL, NULL, nanoseconds < 0 ? NULL : &timeout, NULL) > 0;
+}
+
+/*
+    Reads whatever keys are waiting. The last move (w a s d or an arrow key) replaces key, and every
+    earlier one read at the same time is counted as coalesced. A q sticks, so a key repeating after it can't
+    take the quit back. Returns 1 if a key was taken, 0 if none of
+    them meant anything, and -1 at the end of input.
+*/
+static int readKeys(char* key, unsigned long* coalesced) {
+    char bytes[64];
+    ssize_t length = read(STDIN_FILENO, bytes, sizeof(bytes));
+    if (length == 0) {
+        return -1;
+    }
+    int taken = 0;
+    int quit = 0;
+    for (ssize_t i = 0; i < length; i++) {
+        char next = KEY_NONE;
+        switch (bytes[i]) {
+        case 'w':
+        case 'a':
+        case 's':
+        case 'd':
+        case 'y':
+        case 'n':
+        case KEY_QUIT:
+            next = bytes[i];
+            break;
+        case '\x1b':
+            // Arrow keys arrive as ESC [ A to D. One split across two reads is simply lost.
+            if (i + 2 < length && bytes[i + 1] == '[') {
+                switch (bytes[i + 2]) {
+                case 'A':
+                    next = 'w';
+                    break;
+                case 'B':
+                    next = 's';
+                    break;
+                case 'C':
+                    next = 'd';
+                    break;
+                case 'D':
+                    next = 'a';
+                    break;
+                }
+                i += 2;
+            }
+            break;
+        }
+        if (next == KEY_NONE) {
+            continue;
+        }
+        if (taken > 0) {
+            (*coalesced)++;
+        }
+        if (!quit) {
+            *key = next;
+            quit = next == KEY_QUIT;
+        }
+        taken++;
+    }
+    return taken > 0;
+}
+
+static void requestStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
@@ -0,0 +1,35 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include "game.h"
+#include "render.h"
+#include "replay.h"
+
+/*
+    How a real-time session went. Times are in nanoseconds.
+    Jitter is how late each tick started against its slot on the fixed timestep, and latency is how long
+    after a key arrived the frame showing its move had been sent.
+*/
+struct RealtimeStats {
+    unsigned long ticks;
+    // Ticks dropped because the loop fell more than a whole tick behind
+    unsigned long skippedTicks;
+    long long jitterTotal;
+    long long jitterMax;
+    unsigned long inputs;
+    // Keys thrown away because a later one arrived before the same tick
+    unsigned long coalescedKeys;
+    long long latencyTotal;
+    long long latencyMax;
+};
+
+/*
+    Plays the game in real time: the terminal is put in raw mode, keys are read without blocking, and the
+    zombies move every tickMilliseconds whether the player does or not. Of the keys pressed during one tick
+    only the last counts, so holding a key down moves the player once per tick.
+    Every tick is recorded to replay, unless it is NULL.
+    Returns when the player quits with q, Ctrl-C or the end of input.
+*/
+void runRealtime(struct Game*, struct Renderer*, int tickMilliseconds, struct ReplayWriter* replay, struct RealtimeStats*);
+
+#endif
@@ -0,0 +1,181 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "render.h"
+#include "stats.h"
+
+// Longest cursor move, "\x1b[rrrrr;ccccccH", plus a two character icon
+#define CELL_BYTES 18
+
+static size_t drawFrame(struct Renderer*, const struct Game*, int top, int left, const char* message);
+static void countFrame(struct Renderer*, size_t length, long long start);
+static size_t moveCursor(char* out, int row, int column);
+static int writeAll(int fd, const char* buffer, size_t length);
+
+struct Renderer* createRenderer(int rows, int columns) {
+    struct Renderer* renderer = calloc(1, sizeof(struct Renderer));
+    if (renderer == NULL) {
+        return NULL;
+    }
+    renderer -> rows = rows;
+    renderer -> columns = columns;
+    renderer -> fd = STDOUT_FILENO;
+    renderer -> shown = calloc((size_t)rows * columns, sizeof(const char*));
+    // Every tile changing, plus the clear screen, message and cursor moves around it
+    renderer -> capacity = (size_t)rows * columns * CELL_BYTES + sizeof(renderer -> shownMessage) + 4 * CELL_BYTES;
+    renderer -> buffer = malloc(renderer -> capacity);
+    if (renderer -> shown == NULL || renderer -> buffer == NULL) {
+        destroyRenderer(renderer);
+        return NULL;
+    }
+    invalidateRenderer(renderer);
+    return renderer;
+}
+
+void destroyRenderer(struct Renderer* renderer) {
+    if (renderer == NULL) {
+        return;
+    }
+    free(renderer -> shown);
+    free(renderer -> buffer);
+    free(renderer);
+}
+
+void invalidateRenderer(struct Renderer* renderer) {
+    memset(renderer -> shown, 0, (size_t)renderer -> rows * renderer -> columns * sizeof(const char*));
+    // Not a message anyone would show, so the message line is always redrawn too
+    strcpy(renderer -> shownMessage, "\n");
+}
+
+long renderFrame(struct Renderer* renderer, const struct Game* game, int top, int left, const char* message) {
+    STATS_BEGIN(PHASE_RENDER);
+    long long start = monotonicNanoseconds();
+    size_t length = drawFrame(renderer, game, top, left, message);
+    int written = writeAll(renderer -> fd, renderer -> buffer, length);
+    countFrame(renderer, length, start);
+    STATS_END(PHASE_RENDER);
+    if (!written) {
+        invalidateRenderer(renderer);
+        return -1;
+    }
+    return (long)length;
+}
+
+size_t buildFrame(struct Renderer* renderer, const struct Game* game, int top, int left, const char* message) {
+    STATS_BEGIN(PHASE_RENDER);
+    long long start = monotonicNanoseconds();
+    size_t length = drawFrame(renderer, game, top, left, message);
+    countFrame(renderer, length, start);
+    STATS_END(PHASE_RENDER);
+    return length;
+}
+
+// Fills the renderer's buffer with the frame and returns its length
+static size_t drawFrame(struct Renderer* renderer, const struct Game* game, int top, int left, const char* message) {
+    char* out = renderer -> buffer;
+    size_t length = 0;
+    int rows = renderer -> rows;
+    int columns = renderer -> columns;
+    if (rows > game -> map -> rows) {
+        rows = game -> map -> rows;
+    }
+    if (columns > game -> map -> columns) {
+        columns = game -> map -> columns;
+    }
+
+    // Nothing is known to be on screen, so start from a blank one
+    if (renderer -> shown[0] == NULL) {
+        memcpy(out, "\x1b[H\x1b[2J", 7);
+        length += 7;
+    }
+
+    // Terminal rows and columns count from 1, and every tile is two characters wide.
+    // The cursor is tracked so a run of changed tiles only needs one move.
+    int cursorRow = 0;
+    int cursorColumn = 0;
+    for (int row = 0; row < rows; row++) {
+        const char** shown = &renderer -> shown[row * renderer -> columns];
+        for (int column = 0; column < columns; column++) {
+            const char* icon = cellIcon(game, top + row, left + column);
+            if (shown[column] == icon) {
+                continue;
+            }
+            shown[column] = icon;
+            if (cursorRow != row + 1 || cursorColumn != 2 * column + 1) {
+                length += moveCursor(out + length, row + 1, 2 * column + 1);
+            }
+            out[length++] = icon[0];
+            out[length++] = icon[1];
+            cursorRow = row + 1;
+            cursorColumn = 2 * column + 3;
+        }
+    }
+
+    // The message goes one blank line under the map. Only as much of it as shownMessage holds is drawn,
+    // so only that much is compared, or a long message would count as changed every frame.
+    size_t messageLength = strlen(message);
+    if (messageLength > sizeof(renderer -> shownMessage) - 1) {
+        messageLength = sizeof(renderer -> shownMessage) - 1;
+    }
+    if (strlen(renderer -> shownMessage) != messageLength || memcmp(renderer -> shownMessage, message, messageLength) != 0) {
+        memcpy(renderer -> shownMessage, message, messageLength);
+        renderer -> shownMessage[messageLength] = '\0';
+        length += moveCursor(out + length, rows + 2, 1);
+        memcpy(out + length, renderer -> shownMessage, messageLength);
+        length += messageLength;
+        memcpy(out + length, "\x1b[K", 3);
+        length += 3;
+    }
+
+    // And the player types on the line below that, which is wiped of whatever they typed last time
+    length += moveCursor(out + length, rows + 3, 1);
+    memcpy(out + length, "\x1b[K", 3);
+    length += 3;
+
+    return length;
+}
+
+static void countFrame(struct Renderer* renderer, size_t length, long long start) {
+    renderer -> frames++;
+    renderer -> lastBytes = length;
+    renderer -> totalBytes += length;
+    renderer -> lastNanoseconds = monotonicNanoseconds() - start;
+    renderer -> totalNanoseconds += renderer -> lastNanoseconds;
+}
+
+static size_t moveCursor(char* out, int row, int column) {
+    return (size_t)sprintf(out, "\x1b[%d;%dH", row, column);
+}
+
+// One write almost always takes the whole frame, but a terminal that is slow to drain may take it in parts
+static int writeAll(int fd, const char* buffer, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return 0;
+        }
+        buffer += written;
+        length -= (size_t)written;
+    }
+    return 1;
+}
+
+int viewStart(int player, int size, int view) {
+    int start = player - view / 2;
+    if (start > size - view) {
+        start = size - view;
+    }
+    if (start < 0) {
+        start = 0;
+    }
+    return start;
+}
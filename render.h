@@ -0,0 +1,55 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stddef.h>
+
+#include "game.h"
+
+// Largest part of the map drawn at once, in tiles; bigger floors scroll to keep the player in view
+#define VIEW_ROWS 24
+#define VIEW_COLUMNS 40
+
+/*
+    A Renderer draws a view of a game to the terminal. Each frame is built in one buffer and sent with a
+    single write. The first frame clears the screen and draws everything; after that only the tiles and
+    message that changed are sent, each reached with an ANSI cursor move.
+
+    shown holds the icon on screen for every tile of the view (NULL when it isn't known) and shownMessage
+    the message line, which is what each frame is compared against.
+*/
+struct Renderer {
+    int rows;
+    int columns;
+    // Where frames are written, standard output unless changed
+    int fd;
+    const char** shown;
+    char shownMessage[128];
+    char* buffer;
+    size_t capacity;
+
+    // How much each frame cost to build and send
+    unsigned long frames;
+    size_t lastBytes;
+    unsigned long long totalBytes;
+    long lastNanoseconds;
+    unsigned long long totalNanoseconds;
+};
+
+// rows and columns are the size of the view, in tiles. Returns NULL when out of memory.
+struct Renderer* createRenderer(int rows, int columns);
+void destroyRenderer(struct Renderer*);
+
+/*
+    Draws the tiles of the game's map from top, left onwards, with message on the line below them, and leaves
+    the cursor on a clear line underneath for the player's input. Returns the number of bytes sent, or -1 if
+    they couldn't be written.
+*/
+long renderFrame(struct Renderer*, const struct Game*, int top, int left, const char* message);
+// Builds the same frame in the renderer's buffer without sending it, for callers that send it themselves. Returns its length.
+size_t buildFrame(struct Renderer*, const struct Game*, int top, int left, const char* message);
+// First row (or column) to draw so the player stays in the middle of the view without running off the map
+int viewStart(int player, int size, int view);
+// Forgets what is on screen, so the next frame is drawn in full. Needed after anything else prints.
+void invalidateRenderer(struct Renderer*);
+
+#endif
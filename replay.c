@@ -0,0 +1,320 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+#include "render.h"
+#include "replay.h"
+
+#define REPLAY_VERSION 1
+
+// What the top three bits of a run byte stand for
+enum ReplaySymbol {
+    SYMBOL_NONE,
+    SYMBOL_UP,
+    SYMBOL_LEFT,
+    SYMBOL_DOWN,
+    SYMBOL_RIGHT,
+    SYMBOL_RESET,
+    SYMBOL_END
+};
+
+// Runs this long or longer carry the rest of their length in a varint
+#define LONG_RUN 32
+
+static const char symbolInputs[] = {0, 'w', 'a', 's', 'd'};
+
+static void flushRun(struct ReplayWriter*);
+static void putNumber(FILE*, unsigned long long value, int bytes);
+static int getNumber(FILE*, unsigned long long* value, int bytes);
+
+struct ReplayWriter* createReplay(const char* path, const struct Map* map, unsigned long long seed, int numZombies, char* error, int errorSize) {
+    struct ReplayWriter* replay = calloc(1, sizeof(struct ReplayWriter));
+    if (replay == NULL) {
+        snprintf(error, errorSize, "Not enough memory to record a replay.");
+        return NULL;
+    }
+    replay -> file = fopen(path, "wb");
+    if (replay -> file == NULL) {
+        snprintf(error, errorSize, "Couldn't create the replay %s.", path);
+        free(replay);
+        return NULL;
+    }
+
+    fwrite("ZRPL", 1, 4, replay -> file);
+    putNumber(replay -> file, REPLAY_VERSION, 4);
+    putNumber(replay -> file, (unsigned int)numZombies, 4);
+    putNumber(replay -> file, seed, 8);
+    putNumber(replay -> file, mapChecksum(map), 8);
+    return replay;
+}
+
+void recordInput(struct ReplayWriter* replay, char input) {
+    unsigned char symbol;
+    switch (input) {
+    case 'w':
+        symbol = SYMBOL_UP;
+        break;
+    case 'a':
+        symbol = SYMBOL_LEFT;
+        break;
+    case 's':
+        symbol = SYMBOL_DOWN;
+        break;
+    case 'd':
+        symbol = SYMBOL_RIGHT;
+        break;
+    default:
+        // Anything else leaves the player where they are, so it all plays back the same
+        symbol = SYMBOL_NONE;
+        break;
+    }
+    if (replay -> run > 0 && symbol != replay -> symbol) {
+        flushRun(replay);
+    }
+    replay -> symbol = symbol;
+    replay -> run++;
+}
+
+void recordReset(struct ReplayWriter* replay) {
+    flushRun(replay);
+    replay -> symbol = SYMBOL_RESET;
+    replay -> run = 1;
+    flushRun(replay);
+}
+
+int closeReplay(struct ReplayWriter* replay) {
+    flushRun(replay);
+    replay -> symbol = SYMBOL_END;
+    replay -> run = 1;
+    flushRun(replay);
+    int written = !ferror(replay -> file);
+    written = fclose(replay -> file) == 0 && written;
+    free(replay);
+    return written;
+}
+
+static void flushRun(struct ReplayWriter* replay) {
+    if (replay -> run == 0) {
+        return;
+    }
+    if (replay -> run < LONG_RUN) {
+        fputc(replay -> symbol << 5 | (replay -> run - 1), replay -> file);
+    }
+    else {
+        fputc(replay -> symbol << 5 | (LONG_RUN - 1), replay -> file);
+        unsigned long rest = replay -> run - LONG_RUN;
+        while (rest >= 128) {
+            fputc((rest & 127) | 128, replay -> file);
+            rest >>= 7;
+        }
+        fputc(rest, replay -> file);
+    }
+    replay -> run = 0;
+}
+
+struct ReplayReader* openReplay(const char* path, char* error, int errorSize) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        snprintf(error, errorSize, "Couldn't open the replay %s.", path);
+        return NULL;
+    }
+    char magic[4];
+    unsigned long long version, zombies;
+    struct ReplayReader* replay = calloc(1, sizeof(struct ReplayReader));
+    if (replay == NULL) {
+        snprintf(error, errorSize, "Not enough memory to play a replay.");
+        fclose(file);
+        return NULL;
+    }
+    replay -> file = file;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "ZRPL", 4) != 0 || !getNumber(file, &version, 4)
+        || !getNumber(file, &zombies, 4) || !getNumber(file, &replay -> seed, 8) || !getNumber(file, &replay -> checksum, 8)) {
+        snprintf(error, errorSize, "%s isn't a replay.", path);
+        closeReplayReader(replay);
+        return NULL;
+    }
+    if (version != REPLAY_VERSION) {
+        snprintf(error, errorSize, "%s is a version %llu replay, which this game can't play.", path, version);
+        closeReplayReader(replay);
+        return NULL;
+    }
+    replay -> numZombies = (int)zombies;
+    return replay;
+}
+
+enum ReplayEvent nextReplayEvent(struct ReplayReader* replay, char* input) {
+    if (replay -> run == 0) {
+        int byte = fgetc(replay -> file);
+        if (byte == EOF) {
+            return REPLAY_ERROR;
+        }
+        replay -> symbol = byte >> 5;
+        replay -> run = (byte & 31) + 1;
+        if (replay -> run == LONG_RUN) {
+            for (int shift = 0; ; shift += 7) {
+                byte = fgetc(replay -> file);
+                if (byte == EOF || shift > 56) {
+                    return REPLAY_ERROR;
+                }
+                replay -> run += (unsigned long)(byte & 127) << shift;
+                if (byte < 128) {
+                    break;
+                }
+            }
+        }
+    }
+
+    replay -> run--;
+    switch (replay -> symbol) {
+    case SYMBOL_RESET:
+        return REPLAY_RESET;
+    case SYMBOL_END:
+        replay -> run = 1;
+        return REPLAY_END;
+    default:
+        if (replay -> symbol > SYMBOL_RIGHT) {
+            return REPLAY_ERROR;
+        }
+        *input = symbolInputs[replay -> symbol];
+        return REPLAY_TICK;
+    }
+}
+
+void closeReplayReader(struct ReplayReader* replay) {
+    if (replay == NULL) {
+        return;
+    }
+    fclose(replay -> file);
+    free(replay);
+}
+
+static void putNumber(FILE* file, unsigned long long value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        fputc((value >> (8 * i)) & 255, file);
+    }
+}
+
+static int getNumber(FILE* file, unsigned long long* value, int bytes) {
+    *value = 0;
+    for (int i = 0; i < bytes; i++) {
+        int byte = fgetc(file);
+        if (byte == EOF) {
+            return 0;
+        }
+        *value |= (unsigned long long)byte << (8 * i);
+    }
+    return 1;
+}
+
+int runReplay(int argc, char* argv[]) {
+    const char* replayPath = NULL;
+    const char* mapPath = NULL;
+    unsigned long showEvery = 0;
+    // Ticks to draw, from --show-tick
+    unsigned long* shown = NULL;
+    int numShown = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            mapPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--show-every") == 0 && i + 1 < argc) {
+            showEvery = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--show-tick") == 0 && i + 1 < argc) {
+            unsigned long* grown = realloc(shown, (numShown + 1) * sizeof(unsigned long));
+            if (grown == NULL) {
+                free(shown);
+                return 1;
+            }
+            shown = grown;
+            shown[numShown++] = strtoul(argv[++i], NULL, 10);
+        }
+        else if (replayPath == NULL && argv[i][0] != '-') {
+            replayPath = argv[i];
+        }
+        else {
+            replayPath = NULL;
+            break;
+        }
+    }
+    if (replayPath == NULL) {
+        printf("usage: zombies --replay FILE [--map FILE] [--show-tick T]... [--show-every N]\n");
+        free(shown);
+        return 1;
+    }
+
+    char error[100];
+    struct ReplayReader* replay = openReplay(replayPath, error, sizeof(error));
+    struct Map* map = NULL;
+    if (replay != NULL) {
+        map = mapPath != NULL ? loadMap(mapPath, error, sizeof(error)) : createOfficeMap();
+        if (map == NULL && mapPath == NULL) {
+            snprintf(error, sizeof(error), "Not enough memory for the map.");
+        }
+    }
+    if (map != NULL && mapChecksum(map) != replay -> checksum) {
+        snprintf(error, sizeof(error), "The replay was recorded on a different map; pass it with --map.");
+        destroyMap(map);
+        map = NULL;
+    }
+    struct Game* game = map != NULL ? createGame(map, replay -> seed, replay -> numZombies) : NULL;
+    if (game == NULL) {
+        printf("%s\n", map != NULL ? "Not enough memory to start the game." : error);
+        destroyMap(map);
+        closeReplayReader(replay);
+        free(shown);
+        return 1;
+    }
+
+    unsigned long ticks = 0;
+    unsigned long rounds = 1;
+    enum GameOutcome outcome = GAME_RUNNING;
+    enum ReplayEvent event;
+    char input;
+    long long start = monotonicNanoseconds();
+
+    while ((event = nextReplayEvent(replay, &input)) != REPLAY_END && event != REPLAY_ERROR) {
+        if (event == REPLAY_RESET) {
+            resetGame(game);
+            outcome = GAME_RUNNING;
+            rounds++;
+            continue;
+        }
+        outcome = stepGame(game, input);
+        ticks++;
+
+        char show = showEvery > 0 && ticks % showEvery == 0;
+        for (int i = 0; i < numShown && !show; i++) {
+            show = shown[i] == ticks;
+        }
+        if (show) {
+            printf("tick %lu, round %lu, player at %d,%d\n", ticks, rounds, game -> Player.xcoord, game -> Player.ycoord);
+            int top = viewStart(game -> Player.ycoord, map -> rows, VIEW_ROWS);
+            int left = viewStart(game -> Player.xcoord, map -> columns, VIEW_COLUMNS);
+            for (int row = top; row < map -> rows && row < top + VIEW_ROWS; row++) {
+                for (int column = left; column < map -> columns && column < left + VIEW_COLUMNS; column++) {
+                    fputs(cellIcon(game, row, column), stdout);
+                }
+                putchar('\n');
+            }
+            putchar('\n');
+        }
+    }
+
+    double seconds = secondsSince(start);
+    static const char* outcomes[] = {"still running", "escaped", "died"};
+    printf("ticks: %lu  rounds: %lu  last round: %s  seconds: %.3f  ticks/sec: %.0f\n",
+        ticks, rounds, outcomes[outcome], seconds, seconds > 0 ? ticks / seconds : 0.0);
+    if (event == REPLAY_ERROR) {
+        printf("The replay ends early; it may have been cut short.\n");
+    }
+
+    destroyGame(game);
+    destroyMap(map);
+    closeReplayReader(replay);
+    free(shown);
+    return event == REPLAY_ERROR;
+}
@@ -0,0 +1,66 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdio.h>
+
+#include "game.h"
+
+/*
+    A replay is everything needed to play a game again exactly: the map's checksum, the seed, the size of the
+    horde, and the input of every tick. Since the game is deterministic, nothing else is stored.
+
+    After a 28 byte header ("ZRPL", version, zombies, seed, map checksum, all little endian) come runs of
+    the same input, one byte each: the top three bits say what happened (no move, w, a, s, d, the round
+    being reset, or the end of the replay) and the low five how many ticks in a row, less one. 31 means 32
+    or more, with the rest following as a varint. A player who mostly stands still or walks in straight
+    lines costs a few bytes a second.
+*/
+
+enum ReplayEvent {
+    REPLAY_TICK,
+    REPLAY_RESET,
+    REPLAY_END,
+    REPLAY_ERROR
+};
+
+// Writes a replay out as it is played. Only the current run is held in memory; the file is streamed through stdio.
+struct ReplayWriter {
+    FILE* file;
+    unsigned char symbol;
+    unsigned long run;
+};
+
+// Reads a replay back in, a run at a time
+struct ReplayReader {
+    FILE* file;
+    unsigned long long seed;
+    unsigned long long checksum;
+    int numZombies;
+    unsigned char symbol;
+    unsigned long run;
+};
+
+// Returns NULL and fills in error if the file can't be created
+struct ReplayWriter* createReplay(const char* path, const struct Map*, unsigned long long seed, int numZombies, char* error, int errorSize);
+// One call per stepGame, with the input it was given
+void recordInput(struct ReplayWriter*, char input);
+// One call per resetGame
+void recordReset(struct ReplayWriter*);
+// Ends the replay and closes the file. Returns 0 if anything failed to be written.
+int closeReplay(struct ReplayWriter*);
+
+struct ReplayReader* openReplay(const char* path, char* error, int errorSize);
+/*
+    The next thing that happened. For REPLAY_TICK input is set to what stepGame was given.
+    REPLAY_ERROR means the file is cut short or corrupt.
+*/
+enum ReplayEvent nextReplayEvent(struct ReplayReader*, char* input);
+void closeReplayReader(struct ReplayReader*);
+
+/*
+    Plays a replay back headless, as fast as the machine allows, and reports how it went.
+    Takes the command line that follows "--replay".
+*/
+int runReplay(int argc, char* argv[]);
+
+#endif
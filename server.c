@@ -0,0 +1,612 @@
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "pool.h"
+#include "render.h"
+#include "server.h"
+
+#define DEFAULT_PORT 4000
+#define DEFAULT_MAX_SESSIONS 10000
+// Sessions come from the allocator this many at a time
+#define SESSION_BLOCK 64
+// Keys read from a connection in one go; anything past this waits in the socket for the next loop
+#define SESSION_INPUT 64
+// Sessions with input are handed to the pool's threads in chunks of this size
+#define SESSION_CHUNK 16
+#define MAX_EVENTS 256
+
+static const char* welcomeMessage = "Escape the office without getting eaten by hungry zombies! Use w a s d to move, q to quit.";
+
+enum SessionState {
+    SESSION_PLAYING,
+    // The round is over and the player was asked whether to play again
+    SESSION_ASKING,
+    SESSION_CLOSING
+};
+
+/*
+    Everything one connection needs. The Game and Renderer belong to the slot rather than the connection:
+    when a session ends they are kept, and the next connection to get the slot reseeds and reuses them.
+
+    frame holds frameLength bytes in the renderer's buffer, of which frameSent have gone out. While some are
+    left, the session waits for the socket to drain and reads nothing more, so a slow client only ever holds
+    one frame.
+*/
+struct Session {
+    int fd;
+    unsigned char state;
+    unsigned char inputLength;
+    char queued;
+    char waitingToWrite;
+    const char* message;
+    char input[SESSION_INPUT];
+    size_t frameLength;
+    size_t frameSent;
+    struct Game* game;
+    struct Renderer* renderer;
+    struct Session* nextFree;
+};
+
+struct SessionBlock {
+    struct SessionBlock* next;
+    struct Session sessions[SESSION_BLOCK];
+};
+
+// A free list of session slots, grown a block at a time and never shrunk
+struct SessionPool {
+    struct SessionBlock* blocks;
+    struct Session* free;
+    int live;
+    int peak;
+};
+
+struct Server {
+    int epoll;
+    int listener;
+    const struct Map* map;
+    int zombies;
+    // Sets every session's levelOfDetail
+    char levelOfDetail;
+    unsigned long long seed;
+    unsigned long long connections;
+    int maxSessions;
+    struct SessionPool sessions;
+    // Sessions with something to do this time round the loop: input to play, a first frame, or closing
+    struct Session** ready;
+    int numReady;
+    struct Pool* pool;
+};
+
+static volatile sig_atomic_t stopRequested;
+
+static int openListener(int port, const char* socketPath);
+static void acceptSessions(struct Server*);
+static void readSession(struct Server*, struct Session*);
+static void queueSession(struct Server*, struct Session*);
+static void serveChunk(void* server, int chunk);
+static void serveSession(struct Session*);
+static void flushSession(struct Server*, struct Session*);
+static void closeSession(struct Server*, struct Session*);
+static struct Session* allocateSession(struct SessionPool*);
+static void releaseSession(struct SessionPool*, struct Session*);
+static void destroySessions(struct SessionPool*, unsigned long* frames, unsigned long long* bytes, unsigned long long* nanoseconds);
+static void requestStop(int);
+static void printServerUsage(void);
+
+int runServer(int argc, char* argv[]) {
+    struct Server server;
+    memset(&server, 0, sizeof(server));
+    server.zombies = -1;
+    server.seed = time(0);
+    server.maxSessions = DEFAULT_MAX_SESSIONS;
+    int port = DEFAULT_PORT;
+    const char* socketPath = NULL;
+    const char* mapPath = NULL;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--max-sessions") == 0 && i + 1 < argc) {
+            server.maxSessions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            mapPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--zombies") == 0 && i + 1 < argc) {
+            server.zombies = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            server.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--lod") == 0) {
+            server.levelOfDetail = 1;
+        }
+        else {
+            printServerUsage();
+            return 1;
+        }
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (server.maxSessions < 1) {
+        printServerUsage();
+        return 1;
+    }
+
+    // Every session plays on the same map
+    char error[100];
+    struct Map* map = mapPath != NULL ? loadMap(mapPath, error, sizeof(error)) : createOfficeMap();
+    if (map == NULL) {
+        printf("%s\n", mapPath != NULL ? error : "Not enough memory for the map.");
+        return 1;
+    }
+    server.map = map;
+    if (server.zombies < 0) {
+        server.zombies = map -> numZombieSpawns;
+    }
+
+    // Ctrl-C and SIGTERM only get through while the loop is waiting, so they never cut a turn in half.
+    // They are blocked before the pool starts, so its threads never take them either.
+    stopRequested = 0;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigset_t blocked, waiting;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGINT);
+    sigaddset(&blocked, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &blocked, &waiting);
+    sigdelset(&waiting, SIGINT);
+    sigdelset(&waiting, SIGTERM);
+
+    server.ready = malloc(server.maxSessions * sizeof(struct Session*));
+    server.pool = createPool(threads);
+    server.listener = openListener(port, socketPath);
+    server.epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (server.ready == NULL || server.pool == NULL || server.listener < 0 || server.epoll < 0) {
+        if (server.listener < 0 && socketPath != NULL) {
+            printf("Couldn't listen on %s: %s\n", socketPath, strerror(errno));
+        }
+        else if (server.listener < 0) {
+            printf("Couldn't listen on port %d: %s\n", port, strerror(errno));
+        }
+        else {
+            printf("Not enough memory to start the server.\n");
+        }
+        if (server.listener >= 0) {
+            close(server.listener);
+        }
+        if (server.epoll >= 0) {
+            close(server.epoll);
+        }
+        destroyPool(server.pool);
+        pthread_sigmask(SIG_UNBLOCK, &blocked, NULL);
+        free(server.ready);
+        destroyMap(map);
+        return 1;
+    }
+    struct epoll_event listening;
+    listening.events = EPOLLIN;
+    listening.data.ptr = NULL;
+    epoll_ctl(server.epoll, EPOLL_CTL_ADD, server.listener, &listening);
+
+    if (socketPath != NULL) {
+        fprintf(stderr, "listening on %s with %d threads\n", socketPath, poolThreads(server.pool));
+    }
+    else {
+        fprintf(stderr, "listening on 127.0.0.1:%d with %d threads\n", port, poolThreads(server.pool));
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    while (!stopRequested) {
+        int count = epoll_pwait(server.epoll, events, MAX_EVENTS, -1, &waiting);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        // Gather what every connection sent, without playing any of it yet
+        for (int i = 0; i < count; i++) {
+            struct Session* session = events[i].data.ptr;
+            if (session == NULL) {
+                acceptSessions(&server);
+            }
+            else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                session -> state = SESSION_CLOSING;
+                queueSession(&server, session);
+            }
+            else if (events[i].events & EPOLLOUT) {
+                flushSession(&server, session);
+            }
+            else if (events[i].events & EPOLLIN) {
+                readSession(&server, session);
+            }
+        }
+
+        // Play every session's turns and draw their frames, spread over the pool when there are enough of them
+        if (server.numReady > SESSION_CHUNK) {
+            runPool(server.pool, (server.numReady + SESSION_CHUNK - 1) / SESSION_CHUNK, serveChunk, &server);
+        }
+        else {
+            for (int i = 0; i < server.numReady; i++) {
+                serveSession(server.ready[i]);
+            }
+        }
+
+        // Then send the frames, closing the sessions that are done
+        for (int i = 0; i < server.numReady; i++) {
+            struct Session* session = server.ready[i];
+            session -> queued = 0;
+            if (session -> state == SESSION_CLOSING) {
+                closeSession(&server, session);
+            }
+            else {
+                flushSession(&server, session);
+            }
+        }
+        server.numReady = 0;
+    }
+    unsigned long frames = 0;
+    unsigned long long bytes = 0;
+    unsigned long long nanoseconds = 0;
+    for (struct SessionBlock* block = server.sessions.blocks; block != NULL; block = block -> next) {
+        for (int i = 0; i < SESSION_BLOCK; i++) {
+            if (block -> sessions[i].fd >= 0) {
+                close(block -> sessions[i].fd);
+            }
+        }
+    }
+    destroySessions(&server.sessions, &frames, &bytes, &nanoseconds);
+    fprintf(stderr, "connections: %llu  peak sessions: %d  frames: %lu  bytes/frame: %.1f  us/frame: %.1f\n",
+        server.connections, server.sessions.peak, frames, frames > 0 ? (double)bytes / frames : 0.0,
+        frames > 0 ? nanoseconds / 1e3 / frames : 0.0);
+
+    close(server.epoll);
+    close(server.listener);
+    if (socketPath != NULL) {
+        unlink(socketPath);
+    }
+    destroyPool(server.pool);
+    pthread_sigmask(SIG_UNBLOCK, &blocked, NULL);
+    free(server.ready);
+    destroyMap(map);
+    return 0;
+}
+
+// A Unix socket at socketPath if there is one, otherwise TCP on the loopback interface
+static int openListener(int port, const char* socketPath) {
+    int listener;
+    if (socketPath != NULL) {
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (strlen(socketPath) >= sizeof(address.sun_path)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        strcpy(address.sun_path, socketPath);
+        // A socket left behind by an earlier server is replaced, but anything else at the path is left alone
+        struct stat existing;
+        if (lstat(socketPath, &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                errno = EADDRINUSE;
+                return -1;
+            }
+            unlink(socketPath);
+        }
+        listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            int saved = errno;
+            if (listener >= 0) {
+                close(listener);
+            }
+            errno = saved;
+            return -1;
+        }
+    }
+    else {
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        int reuse = 1;
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener >= 0) {
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (listener < 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) {
+            int saved = errno;
+            if (listener >= 0) {
+                close(listener);
+            }
+            errno = saved;
+            return -1;
+        }
+    }
+    if (listen(listener, SOMAXCONN) != 0) {
+        int saved = errno;
+        close(listener);
+        errno = saved;
+        return -1;
+    }
+    return listener;
+}
+
+// Takes every waiting connection, giving each a session with a fresh game to draw
+static void acceptSessions(struct Server* server) {
+    while (1) {
+        int fd = accept4(server -> listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            return;
+        }
+        if (server -> sessions.live >= server -> maxSessions) {
+            close(fd);
+            continue;
+        }
+        struct Session* session = allocateSession(&server -> sessions);
+        if (session == NULL) {
+            close(fd);
+            continue;
+        }
+
+        // A slot used before still has its game and renderer, which only need a new seed and a blank screen
+        unsigned long long seed = server -> seed + server -> connections++;
+        if (session -> game == NULL) {
+            session -> game = createGame(server -> map, seed, server -> zombies);
+            session -> renderer = createRenderer(VIEW_ROWS, VIEW_COLUMNS);
+            if (session -> game != NULL) {
+                session -> game -> levelOfDetail = server -> levelOfDetail;
+            }
+        }
+        else {
+            seedGame(session -> game, seed);
+            invalidateRenderer(session -> renderer);
+        }
+        if (session -> game == NULL || session -> renderer == NULL) {
+            // The slot goes back empty, so the next connection on it doesn't take half a session for a used one
+            destroyGame(session -> game);
+            destroyRenderer(session -> renderer);
+            session -> game = NULL;
+            session -> renderer = NULL;
+            close(fd);
+            releaseSession(&server -> sessions, session);
+            continue;
+        }
+        session -> fd = fd;
+        session -> state = SESSION_PLAYING;
+        session -> message = welcomeMessage;
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+        if (epoll_ctl(server -> epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            session -> fd = -1;
+            releaseSession(&server -> sessions, session);
+            continue;
+        }
+        queueSession(server, session);
+    }
+}
+
+static void readSession(struct Server* server, struct Session* session) {
+    ssize_t length = read(session -> fd, session -> input + session -> inputLength, SESSION_INPUT - session -> inputLength);
+    if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (length <= 0) {
+        session -> state = SESSION_CLOSING;
+    }
+    else {
+        session -> inputLength += (unsigned char)length;
+    }
+    queueSession(server, session);
+}
+
+static void queueSession(struct Server* server, struct Session* session) {
+    if (!session -> queued) {
+        session -> queued = 1;
+        server -> ready[server -> numReady++] = session;
+    }
+}
+
+static void serveChunk(void* argument, int chunk) {
+    struct Server* server = argument;
+    int first = chunk * SESSION_CHUNK;
+    int last = first + SESSION_CHUNK < server -> numReady ? first + SESSION_CHUNK : server -> numReady;
+    for (int i = first; i < last; i++) {
+        serveSession(server -> ready[i]);
+    }
+}
+
+/*
+    Plays every key the session sent, the way the interactive game does: each w a s d is a turn, and at the
+    end of a round y starts another while n leaves. q leaves at any time. Every other key, such as the newline
+    nc sends after each line, is skipped. Only the frame after the last key is drawn.
+*/
+static void serveSession(struct Session* session) {
+    struct Game* game = session -> game;
+    for (int i = 0; i < session -> inputLength && session -> state != SESSION_CLOSING; i++) {
+        char key = session -> input[i];
+        if (session -> state == SESSION_ASKING) {
+            if (key == 'y') {
+                resetGame(game);
+                session -> state = SESSION_PLAYING;
+                session -> message = welcomeMessage;
+            }
+            else if (key == 'n' || key == 'q') {
+                session -> state = SESSION_CLOSING;
+            }
+            continue;
+        }
+        if (key == 'q') {
+            session -> state = SESSION_CLOSING;
+            continue;
+        }
+        if (key != 'w' && key != 'a' && key != 's' && key != 'd') {
+            continue;
+        }
+        enum GameOutcome outcome = stepGame(game, key);
+        session -> message = game -> playerBlocked ? "I can't go there." : "";
+        if (outcome == GAME_DIED) {
+            session -> message = "You died! Want to play again? (y/n)";
+            session -> state = SESSION_ASKING;
+        }
+        else if (outcome == GAME_ESCAPED) {
+            session -> message = "You escaped! Want to play again? (y/n)";
+            session -> state = SESSION_ASKING;
+        }
+    }
+    session -> inputLength = 0;
+    if (session -> state == SESSION_CLOSING) {
+        return;
+    }
+
+    const struct Map* map = game -> map;
+    session -> frameLength = buildFrame(session -> renderer, game, viewStart(game -> Player.ycoord, map -> rows, VIEW_ROWS),
+        viewStart(game -> Player.xcoord, map -> columns, VIEW_COLUMNS), session -> message);
+    session -> frameSent = 0;
+}
+
+// Sends what is left of the session's frame, and waits for the socket to drain if it won't all go now
+static void flushSession(struct Server* server, struct Session* session) {
+    while (session -> frameSent < session -> frameLength) {
+        ssize_t sent = send(session -> fd, session -> renderer -> buffer + session -> frameSent,
+            session -> frameLength - session -> frameSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!session -> waitingToWrite) {
+                    struct epoll_event event;
+                    event.events = EPOLLOUT;
+                    event.data.ptr = session;
+                    epoll_ctl(server -> epoll, EPOLL_CTL_MOD, session -> fd, &event);
+                    session -> waitingToWrite = 1;
+                }
+                return;
+            }
+            closeSession(server, session);
+            return;
+        }
+        session -> frameSent += (size_t)sent;
+    }
+    if (session -> waitingToWrite) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+        epoll_ctl(server -> epoll, EPOLL_CTL_MOD, session -> fd, &event);
+        session -> waitingToWrite = 0;
+    }
+}
+
+static void closeSession(struct Server* server, struct Session* session) {
+    if (session -> fd >= 0) {
+        epoll_ctl(server -> epoll, EPOLL_CTL_DEL, session -> fd, NULL);
+        close(session -> fd);
+        session -> fd = -1;
+    }
+    // A session queued again before it could be closed is left for the loop, which closes it then
+    if (session -> queued) {
+        session -> state = SESSION_CLOSING;
+        return;
+    }
+    releaseSession(&server -> sessions, session);
+}
+
+static struct Session* allocateSession(struct SessionPool* pool) {
+    if (pool -> free == NULL) {
+        struct SessionBlock* block = calloc(1, sizeof(struct SessionBlock));
+        if (block == NULL) {
+            return NULL;
+        }
+        block -> next = pool -> blocks;
+        pool -> blocks = block;
+        for (int i = SESSION_BLOCK - 1; i >= 0; i--) {
+            block -> sessions[i].fd = -1;
+            block -> sessions[i].nextFree = pool -> free;
+            pool -> free = &block -> sessions[i];
+        }
+    }
+    struct Session* session = pool -> free;
+    pool -> free = session -> nextFree;
+    session -> nextFree = NULL;
+    session -> inputLength = 0;
+    session -> queued = 0;
+    session -> waitingToWrite = 0;
+    session -> frameLength = 0;
+    session -> frameSent = 0;
+    pool -> live++;
+    if (pool -> live > pool -> peak) {
+        pool -> peak = pool -> live;
+    }
+    return session;
+}
+
+static void releaseSession(struct SessionPool* pool, struct Session* session) {
+    session -> nextFree = pool -> free;
+    pool -> free = session;
+    pool -> live--;
+}
+
+// Frees every slot along with its game and renderer, adding up what the renderers drew
+static void destroySessions(struct SessionPool* pool, unsigned long* frames, unsigned long long* bytes, unsigned long long* nanoseconds) {
+    struct SessionBlock* block = pool -> blocks;
+    while (block != NULL) {
+        struct SessionBlock* next = block -> next;
+        for (int i = 0; i < SESSION_BLOCK; i++) {
+            struct Session* session = &block -> sessions[i];
+            if (session -> renderer != NULL) {
+                *frames += session -> renderer -> frames;
+                *bytes += session -> renderer -> totalBytes;
+                *nanoseconds += session -> renderer -> totalNanoseconds;
+            }
+            destroyRenderer(session -> renderer);
+            destroyGame(session -> game);
+        }
+        free(block);
+        block = next;
+    }
+    pool -> blocks = NULL;
+    pool -> free = NULL;
+    pool -> live = 0;
+}
+
+static void requestStop(int signal) {
+    (void)signal;
+    stopRequested = 1;
+}
+
+static void printServerUsage(void) {
+    printf("usage: zombies --server [--port N | --socket PATH] [--threads N] [--max-sessions N] [--map FILE] [--zombies N] [--seed S] [--lod]\n");
+}
@@ -0,0 +1,11 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/*
+    Hosts many games at once over a socket, one per connection, each played like the interactive game:
+    w a s d moves, y or n answers the question at the end of a round, q leaves.
+    Takes the command line that follows "--server", and returns when interrupted.
+*/
+int runServer(int argc, char* argv[]);
+
+#endif
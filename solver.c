@@ -0,0 +1,428 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "clock.h"
+#include "game.h"
+#include "pool.h"
+
+/*
+    Answers "can the player still escape?" for a map, a seed and a horde, by trying every sequence of moves.
+
+    Zombies have no choices of their own: given where everyone stands, the tick and the round's random key,
+    their moves are fixed, as the flow field they chase along depends on the player's tile alone (see
+    updateFlowField in game.c). So the search is over the player's moves alone, breadth first, one tick at a
+    time. A state is the tick plus where the player and every zombie stand. States reached twice are only expanded
+    once, thanks to a transposition table; the first path found to the door is the shortest there is.
+
+    The answer is one of: the player can escape (and how), every line of play gets the player eaten by some
+    tick, nothing was settled within the tick horizon, or the memory budget ran out first.
+*/
+
+#define DEFAULT_MAX_TICKS 200
+#define DEFAULT_MEMORY_MB 256
+// The player's choices each tick: the four steps, or waiting where they are
+static const char playerInputs[5] = {'w', 'a', 's', 'd', '.'};
+
+enum SolverVerdict {
+    VERDICT_ESCAPE,
+    VERDICT_TRAPPED,
+    VERDICT_HORIZON,
+    VERDICT_MEMORY
+};
+
+static const char* verdictNames[] = {"escape", "trapped", "horizon", "memory"};
+
+/*
+    Every state reached so far, stored back to back in one block: a header saying which state it was reached
+    from and how, then where the player and each zombie stand. table maps hashes to state numbers + 1
+    (0 is an empty slot), by linear probing.
+*/
+struct Solver {
+    struct Game* game;
+    // The state being expanded, restored before each of its children is played
+    struct GameSnapshot* parent;
+    int numZombies;
+    size_t stateBytes;
+    unsigned char* states;
+    unsigned int capacity;
+    unsigned int count;
+    unsigned int* table;
+    unsigned int tableMask;
+};
+
+struct StateHeader {
+    unsigned int parent;
+    unsigned int tick;
+    char input;
+};
+
+struct SolverResult {
+    enum SolverVerdict verdict;
+    // When the player escaped, or when the last of them was eaten
+    unsigned long ticks;
+    unsigned long states;
+    double seconds;
+    // The winning moves, one character a tick, '.' for waiting. Empty unless the verdict is VERDICT_ESCAPE.
+    char* moves;
+};
+
+struct Layout {
+    const char* mapPath;
+    const struct Map* map;
+    unsigned long long seed;
+    int zombies;
+};
+
+struct SweepOptions {
+    int zombies;
+    char randomSpawns;
+    unsigned long maxTicks;
+    size_t memoryBytes;
+    struct Layout* layouts;
+    struct SolverResult* results;
+    int numLayouts;
+};
+
+static struct SolverResult solveLayout(const struct Map*, unsigned long long seed, int zombies, unsigned long maxTicks, size_t memoryBytes);
+static int findOrAdd(struct Solver*, unsigned int parent, unsigned int tick, char input, char* added);
+static void loadState(struct Solver*, unsigned int state);
+static unsigned long long hashState(const unsigned char* bytes, size_t length, unsigned int tick);
+static void solveTask(void* options, int layout);
+static void printSolverUsage(void);
+
+/*
+    solver [options] MAP...
+    Every map is solved for --sweep seeds in a row, starting at --seed, spread over --threads threads.
+    A line of tab separated results is printed per layout, in order.
+*/
+int main(int argc, char* argv[]) {
+    struct SweepOptions options;
+    memset(&options, 0, sizeof(options));
+    options.zombies = -1;
+    options.maxTicks = DEFAULT_MAX_TICKS;
+    options.memoryBytes = (size_t)DEFAULT_MEMORY_MB << 20;
+    unsigned long long seed = 1;
+    int sweep = 1;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    char showMoves = 0;
+    const char** mapPaths = calloc(argc, sizeof(const char*));
+    int numMaps = 0;
+    if (mapPaths == NULL) {
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--sweep") == 0 && i + 1 < argc) {
+            sweep = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--zombies") == 0 && i + 1 < argc) {
+            options.zombies = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--random-spawns") == 0) {
+            options.randomSpawns = 1;
+        }
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) {
+            options.maxTicks = strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) {
+            options.memoryBytes = (size_t)strtoul(argv[++i], NULL, 10) << 20;
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--moves") == 0) {
+            showMoves = 1;
+        }
+        else if (argv[i][0] != '-') {
+            mapPaths[numMaps++] = argv[i];
+        }
+        else {
+            printSolverUsage();
+            free(mapPaths);
+            return 1;
+        }
+    }
+    if (sweep < 1 || threads < 1) {
+        printSolverUsage();
+        free(mapPaths);
+        return 1;
+    }
+
+    // No maps means the office
+    int loadedMaps = numMaps > 0 ? numMaps : 1;
+    struct Map** maps = calloc(loadedMaps, sizeof(struct Map*));
+    options.numLayouts = loadedMaps * sweep;
+    options.layouts = calloc(options.numLayouts, sizeof(struct Layout));
+    options.results = calloc(options.numLayouts, sizeof(struct SolverResult));
+    int failed = maps == NULL || options.layouts == NULL || options.results == NULL;
+    for (int i = 0; i < loadedMaps && !failed; i++) {
+        char error[100];
+        maps[i] = numMaps > 0 ? loadMap(mapPaths[i], error, sizeof(error)) : createOfficeMap();
+        if (maps[i] == NULL) {
+            printf("%s\n", numMaps > 0 ? error : "Not enough memory for the map.");
+            failed = 1;
+            break;
+        }
+        // Without --zombies, a map gets as many zombies as it has spawns. A sweep of spawn layouts then places
+        // every one of them at random, ignoring the map's own spawns.
+        int zombies = options.zombies >= 0 ? options.zombies : maps[i] -> numZombieSpawns;
+        if (options.randomSpawns) {
+            maps[i] -> numZombieSpawns = 0;
+        }
+        for (int j = 0; j < sweep; j++) {
+            struct Layout* layout = &options.layouts[i * sweep + j];
+            layout -> mapPath = numMaps > 0 ? mapPaths[i] : "office";
+            layout -> map = maps[i];
+            layout -> seed = seed + j;
+            layout -> zombies = zombies;
+        }
+    }
+
+    if (!failed) {
+        // Each layout gets an even share of the memory budget
+        options.memoryBytes /= threads < options.numLayouts ? threads : options.numLayouts;
+        struct Pool* pool = createPool(threads);
+        if (pool == NULL) {
+            failed = 1;
+        }
+        else {
+            long long start = monotonicNanoseconds();
+            runPool(pool, options.numLayouts, solveTask, &options);
+            destroyPool(pool);
+
+            int counts[4] = {0, 0, 0, 0};
+            printf("map\tseed\tverdict\tticks\tstates\tseconds%s\n", showMoves ? "\tmoves" : "");
+            for (int i = 0; i < options.numLayouts; i++) {
+                struct SolverResult* result = &options.results[i];
+                counts[result -> verdict]++;
+                printf("%s\t%llu\t%s\t%lu\t%lu\t%.3f", options.layouts[i].mapPath, options.layouts[i].seed,
+                    verdictNames[result -> verdict], result -> ticks, result -> states, result -> seconds);
+                if (showMoves) {
+                    printf("\t%s", result -> moves != NULL ? result -> moves : "");
+                }
+                printf("\n");
+                free(result -> moves);
+            }
+            fprintf(stderr, "layouts: %d  escape: %d  trapped: %d  horizon: %d  memory: %d  seconds: %.3f\n", options.numLayouts,
+                counts[VERDICT_ESCAPE], counts[VERDICT_TRAPPED], counts[VERDICT_HORIZON], counts[VERDICT_MEMORY], secondsSince(start));
+        }
+    }
+
+    for (int i = 0; maps != NULL && i < loadedMaps; i++) {
+        destroyMap(maps[i]);
+    }
+    free(maps);
+    free(options.layouts);
+    free(options.results);
+    free(mapPaths);
+    return failed;
+}
+
+static void solveTask(void* argument, int index) {
+    struct SweepOptions* options = argument;
+    struct Layout* layout = &options -> layouts[index];
+    options -> results[index] = solveLayout(layout -> map, layout -> seed, layout -> zombies, options -> maxTicks, options -> memoryBytes);
+}
+
+static struct SolverResult solveLayout(const struct Map* map, unsigned long long seed, int zombies, unsigned long maxTicks, size_t memoryBytes) {
+    struct SolverResult result;
+    memset(&result, 0, sizeof(result));
+    result.verdict = VERDICT_MEMORY;
+    long long start = monotonicNanoseconds();
+
+    struct Solver solver;
+    memset(&solver, 0, sizeof(solver));
+    solver.game = createGame(map, seed, zombies);
+    if (solver.game == NULL) {
+        return result;
+    }
+    solver.parent = malloc(snapshotSize(solver.game));
+    if (solver.parent == NULL) {
+        destroyGame(solver.game);
+        return result;
+    }
+    solver.numZombies = solver.game -> numZombies;
+    solver.stateBytes = sizeof(struct StateHeader) + (1 + solver.numZombies) * sizeof(struct Spawn);
+    solver.stateBytes = (solver.stateBytes + 3) & ~(size_t)3;
+
+    // Each state costs its own bytes and two table slots, so the table stays at most half full
+    size_t perState = solver.stateBytes + 2 * sizeof(unsigned int);
+    size_t capacity = memoryBytes / perState;
+    if (capacity > 0x7FFFFFFF) {
+        capacity = 0x7FFFFFFF;
+    }
+    size_t tableSize = 1;
+    while (tableSize < 2 * capacity) {
+        tableSize *= 2;
+    }
+    if (tableSize * sizeof(unsigned int) + capacity * solver.stateBytes > memoryBytes) {
+        // Rounding the table up overshot the budget, so take the smaller table and fill what it leaves
+        tableSize /= 2;
+        capacity = (memoryBytes - tableSize * sizeof(unsigned int)) / solver.stateBytes;
+        if (capacity > tableSize / 2) {
+            capacity = tableSize / 2;
+        }
+    }
+    solver.capacity = (unsigned int)capacity;
+    solver.tableMask = (unsigned int)(tableSize - 1);
+    solver.states = malloc((capacity + 1) * solver.stateBytes);
+    solver.table = calloc(tableSize, sizeof(unsigned int));
+    if (capacity == 0 || solver.states == NULL || solver.table == NULL) {
+        free(solver.states);
+        free(solver.table);
+        free(solver.parent);
+        destroyGame(solver.game);
+        return result;
+    }
+
+    // The starting position is state 0
+    char added;
+    findOrAdd(&solver, 0, 0, 0, &added);
+
+    unsigned int layerStart = 0;
+    unsigned int layerEnd = 1;
+    int escapedFrom = -1;
+    char escapedWith = 0;
+    char outOfMemory = 0;
+    unsigned long tick = 0;
+    for (; tick < maxTicks && layerStart < layerEnd && escapedFrom < 0 && !outOfMemory; tick++) {
+        for (unsigned int state = layerStart; state < layerEnd && escapedFrom < 0 && !outOfMemory; state++) {
+            // The parent is put on the board and its flow field searched once. Each child only steps the field,
+            // and restoring the parent takes that step back, so no child searches it again.
+            loadState(&solver, state);
+            refreshFlowField(solver.game);
+            saveGame(solver.game, solver.parent);
+            for (int i = 0; i < 5; i++) {
+                if (i > 0) {
+                    restoreGame(solver.game, solver.parent);
+                }
+                enum GameOutcome outcome = stepGame(solver.game, playerInputs[i]);
+                if (outcome == GAME_ESCAPED) {
+                    escapedFrom = (int)state;
+                    escapedWith = playerInputs[i];
+                    break;
+                }
+                if (outcome == GAME_DIED) {
+                    continue;
+                }
+                if (findOrAdd(&solver, state, (unsigned int)tick + 1, playerInputs[i], &added) < 0) {
+                    outOfMemory = 1;
+                    break;
+                }
+            }
+        }
+        layerStart = layerEnd;
+        layerEnd = solver.count;
+    }
+
+    result.states = solver.count;
+    if (escapedFrom >= 0) {
+        result.verdict = VERDICT_ESCAPE;
+        result.ticks = tick;
+        // Walk back up the parents for the moves that got here
+        result.moves = malloc(tick + 1);
+        if (result.moves != NULL) {
+            result.moves[tick] = '\0';
+            result.moves[tick - 1] = escapedWith;
+            unsigned int state = (unsigned int)escapedFrom;
+            for (unsigned long i = tick - 1; i > 0; i--) {
+                const struct StateHeader* header = (const struct StateHeader*)(solver.states + state * solver.stateBytes);
+                result.moves[i - 1] = header -> input;
+                state = header -> parent;
+            }
+        }
+    }
+    else if (outOfMemory) {
+        result.verdict = VERDICT_MEMORY;
+        result.ticks = tick;
+    }
+    else if (layerStart == layerEnd) {
+        // No line of play survived the last tick searched
+        result.verdict = VERDICT_TRAPPED;
+        result.ticks = tick;
+    }
+    else {
+        result.verdict = VERDICT_HORIZON;
+        result.ticks = tick;
+    }
+
+    free(solver.states);
+    free(solver.table);
+    free(solver.parent);
+    destroyGame(solver.game);
+    result.seconds = secondsSince(start);
+    return result;
+}
+
+/*
+    Looks up where everyone stands in the solver's game at tick, adding it as a new state if it hasn't been
+    seen. Returns the state's number, or -1 when it is new and there is no room left for it.
+*/
+static int findOrAdd(struct Solver* solver, unsigned int parent, unsigned int tick, char input, char* added) {
+    *added = 0;
+
+    // Build the new state in the next free slot, then see whether it's already known. There is one slot past
+    // capacity for this, so a full solver still finds the states it has.
+    unsigned char* candidate = solver -> states + (size_t)solver -> count * solver -> stateBytes;
+    memset(candidate, 0, solver -> stateBytes);
+    struct StateHeader* header = (struct StateHeader*)candidate;
+    header -> tick = tick;
+    struct Spawn* positions = (struct Spawn*)(candidate + sizeof(struct StateHeader));
+    positions[0].xcoord = solver -> game -> Player.xcoord;
+    positions[0].ycoord = solver -> game -> Player.ycoord;
+    for (int i = 0; i < solver -> numZombies; i++) {
+        positions[i + 1].xcoord = solver -> game -> zombies[i].xcoord;
+        positions[i + 1].ycoord = solver -> game -> zombies[i].ycoord;
+    }
+
+    // The parent and input don't make a state different, so only the tick and positions are hashed and compared
+    size_t compareBytes = (1 + solver -> numZombies) * sizeof(struct Spawn);
+    unsigned long long hash = hashState((const unsigned char*)positions, compareBytes, tick);
+    for (unsigned int slot = (unsigned int)hash & solver -> tableMask; ; slot = (slot + 1) & solver -> tableMask) {
+        unsigned int entry = solver -> table[slot];
+        if (entry == 0) {
+            if (solver -> count == solver -> capacity) {
+                return -1;
+            }
+            solver -> table[slot] = solver -> count + 1;
+            header -> parent = parent;
+            header -> input = input;
+            *added = 1;
+            return (int)solver -> count++;
+        }
+        const unsigned char* known = solver -> states + (size_t)(entry - 1) * solver -> stateBytes;
+        if (((const struct StateHeader*)known) -> tick == tick
+            && memcmp(known + sizeof(struct StateHeader), positions, compareBytes) == 0) {
+            return (int)(entry - 1);
+        }
+    }
+}
+
+static void loadState(struct Solver* solver, unsigned int state) {
+    const unsigned char* record = solver -> states + (size_t)state * solver -> stateBytes;
+    const struct StateHeader* header = (const struct StateHeader*)record;
+    const struct Spawn* positions = (const struct Spawn*)(record + sizeof(struct StateHeader));
+    placeActors(solver -> game, positions[0], positions + 1, header -> tick);
+}
+
+// FNV-1a, finished off with a multiply so the low bits used for table slots are well mixed
+static unsigned long long hashState(const unsigned char* bytes, size_t length, unsigned int tick) {
+    unsigned long long hash = 0xCBF29CE484222325ULL ^ tick;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    }
+    hash ^= hash >> 32;
+    return hash * 0x9E3779B97F4A7C15ULL >> 16;
+}
+
+static void printSolverUsage(void) {
+    printf("usage: solver [--seed S] [--sweep N] [--zombies N] [--random-spawns] [--max-ticks T] [--memory MB] [--threads N] [--moves] [MAP...]\n");
+}
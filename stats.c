@@ -0,0 +1,199 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "stats.h"
+
+#ifdef ZOMBIES_STATS
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Histogram buckets are log-linear: below 8 ns every nanosecond has its own bucket, and above that every
+    power of two is split into 8, so any value is placed to within 12.5%.
+*/
+#define SUB_BUCKETS 8
+#define BUCKETS 512
+
+// One thread's numbers. Threads are never taken off the list, so the work of finished threads still counts.
+struct ThreadStats {
+    struct ThreadStats* next;
+    unsigned long long histogram[PHASE_COUNT][BUCKETS];
+    unsigned long long samples[PHASE_COUNT];
+    unsigned long long total[PHASE_COUNT];
+    unsigned long long max[PHASE_COUNT];
+    unsigned long long counters[COUNTER_COUNT];
+};
+
+static const char* phaseNames[PHASE_COUNT] = {
+    "tick", "player", "flow field", "propose", "commit", "collision", "reset", "render", "input wait"
+};
+static const char* counterNames[COUNTER_COUNT] = {
+    "moves attempted", "moves blocked", "moves contested", "flow field rebuilds", "flow field steps",
+    "zombie turns skipped", "region changes"
+};
+
+static _Thread_local struct ThreadStats* threadStats;
+static struct ThreadStats* allStats;
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t statsOnce = PTHREAD_ONCE_INIT;
+// Lock free, so the signal handler may set it, and swapped back so only one thread answers each signal
+static atomic_int reportRequested;
+static atomic_flag reporting = ATOMIC_FLAG_INIT;
+
+static struct ThreadStats* startThread(void);
+static void startStats(void);
+static void requestReport(int);
+static int bucketOf(unsigned long long value);
+static unsigned long long bucketTop(int bucket);
+static unsigned long long percentile(const unsigned long long* histogram, unsigned long long samples, double fraction);
+
+void statsRecord(enum StatsPhase phase, long long nanoseconds) {
+    struct ThreadStats* stats = threadStats != NULL ? threadStats : startThread();
+    if (stats == NULL) {
+        return;
+    }
+    unsigned long long value = nanoseconds > 0 ? (unsigned long long)nanoseconds : 0;
+    stats -> histogram[phase][bucketOf(value)]++;
+    stats -> samples[phase]++;
+    stats -> total[phase] += value;
+    if (value > stats -> max[phase]) {
+        stats -> max[phase] = value;
+    }
+
+    // A SIGUSR1 is answered by whichever thread finishes a phase next
+    if (atomic_load_explicit(&reportRequested, memory_order_relaxed) && atomic_exchange(&reportRequested, 0)) {
+        statsReport();
+    }
+}
+
+void statsAdd(enum StatsCounter counter, long long amount) {
+    struct ThreadStats* stats = threadStats != NULL ? threadStats : startThread();
+    if (stats != NULL) {
+        stats -> counters[counter] += amount;
+    }
+}
+
+/*
+    Adds up every thread's numbers and writes them out. Other threads carry on while this reads their
+    numbers, so a report taken mid-run can be a few samples out; one taken at exit is exact.
+*/
+void statsReport(void) {
+    if (atomic_flag_test_and_set(&reporting)) {
+        return;
+    }
+    static struct ThreadStats sum;
+    memset(&sum, 0, sizeof(sum));
+    pthread_mutex_lock(&statsLock);
+    for (const struct ThreadStats* stats = allStats; stats != NULL; stats = stats -> next) {
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            for (int bucket = 0; bucket < BUCKETS; bucket++) {
+                sum.histogram[phase][bucket] += stats -> histogram[phase][bucket];
+            }
+            sum.samples[phase] += stats -> samples[phase];
+            sum.total[phase] += stats -> total[phase];
+            if (stats -> max[phase] > sum.max[phase]) {
+                sum.max[phase] = stats -> max[phase];
+            }
+        }
+        for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+            sum.counters[counter] += stats -> counters[counter];
+        }
+    }
+    pthread_mutex_unlock(&statsLock);
+
+    const char* path = getenv("ZOMBIES_STATS_FILE");
+    FILE* out = path != NULL ? fopen(path, "a") : stderr;
+    if (out == NULL) {
+        out = stderr;
+    }
+    fprintf(out, "%-12s %12s %10s %10s %10s %10s\n", "phase", "samples", "mean ns", "p50 ns", "p99 ns", "max ns");
+    for (int phase = 0; phase < PHASE_COUNT; phase++) {
+        if (sum.samples[phase] == 0) {
+            continue;
+        }
+        unsigned long long p50 = percentile(sum.histogram[phase], sum.samples[phase], 0.50);
+        unsigned long long p99 = percentile(sum.histogram[phase], sum.samples[phase], 0.99);
+        fprintf(out, "%-12s %12llu %10llu %10llu %10llu %10llu\n", phaseNames[phase], sum.samples[phase],
+            sum.total[phase] / sum.samples[phase], p50 < sum.max[phase] ? p50 : sum.max[phase],
+            p99 < sum.max[phase] ? p99 : sum.max[phase], sum.max[phase]);
+    }
+    for (int counter = 0; counter < COUNTER_COUNT; counter++) {
+        fprintf(out, "%s: %llu\n", counterNames[counter], sum.counters[counter]);
+    }
+    fprintf(out, "\n");
+    if (out != stderr) {
+        fclose(out);
+    }
+    else {
+        fflush(out);
+    }
+    atomic_flag_clear(&reporting);
+}
+
+static struct ThreadStats* startThread(void) {
+    pthread_once(&statsOnce, startStats);
+    struct ThreadStats* stats = calloc(1, sizeof(struct ThreadStats));
+    if (stats == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&statsLock);
+    stats -> next = allStats;
+    allStats = stats;
+    pthread_mutex_unlock(&statsLock);
+    threadStats = stats;
+    return stats;
+}
+
+// The first thread to record anything sets up the exit report and SIGUSR1
+static void startStats(void) {
+    atexit(statsReport);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestReport;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+}
+
+static void requestReport(int signal) {
+    (void)signal;
+    atomic_store(&reportRequested, 1);
+}
+
+static int bucketOf(unsigned long long value) {
+    if (value < SUB_BUCKETS) {
+        return (int)value;
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    return (exponent - 2) * SUB_BUCKETS + (int)((value >> (exponent - 3)) & (SUB_BUCKETS - 1));
+}
+
+// Largest value that lands in a bucket
+static unsigned long long bucketTop(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return bucket;
+    }
+    int exponent = bucket / SUB_BUCKETS + 2;
+    unsigned long long step = 1ULL << (exponent - 3);
+    return ((unsigned long long)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (exponent - 3)) + step - 1;
+}
+
+static unsigned long long percentile(const unsigned long long* histogram, unsigned long long samples, double fraction) {
+    unsigned long long wanted = (unsigned long long)(fraction * samples);
+    if (wanted >= samples) {
+        wanted = samples - 1;
+    }
+    unsigned long long seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += histogram[bucket];
+        if (seen > wanted) {
+            return bucketTop(bucket);
+        }
+    }
+    return bucketTop(BUCKETS - 1);
+}
+
+#endif
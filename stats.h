@@ -0,0 +1,65 @@
+#ifndef STATS_H
+#define STATS_H
+
+/*
+    Optional instrumentation: how long each phase of a turn takes, as a latency histogram, and how often
+    things like blocked moves happen. Build with ZOMBIES_STATS defined (cmake -DZOMBIES_STATS=ON) to turn it
+    on; otherwise every STATS_ macro below compiles to nothing.
+
+    Each thread keeps its own numbers, so timing a phase costs two clock reads and no locking. A report of
+    everything so far, with p50, p99 and max for each phase, is written when the program exits and whenever
+    it gets SIGUSR1. It goes to the file named by the ZOMBIES_STATS_FILE environment variable, or to stderr.
+*/
+
+enum StatsPhase {
+    PHASE_TICK,
+    PHASE_PLAYER,
+    PHASE_FLOW_FIELD,
+    PHASE_PROPOSE,
+    PHASE_COMMIT,
+    PHASE_COLLISION,
+    PHASE_RESET,
+    PHASE_RENDER,
+    PHASE_INPUT_WAIT,
+    PHASE_COUNT
+};
+
+enum StatsCounter {
+    // Zombie turns: calls to moveZombie, and every zombie of every tick
+    COUNTER_MOVES_ATTEMPTED,
+    // Of those, the ones that went nowhere because a wall or another zombie was in the way
+    COUNTER_MOVES_BLOCKED,
+    // Steps given up in a tick because a lower numbered zombie took the tile first
+    COUNTER_MOVES_CONTESTED,
+    COUNTER_FLOW_REBUILDS,
+    COUNTER_FLOW_STEPS,
+    // With level of detail: turns zombies sat out for being far away (which count as blocked moves too),
+    // and how often far ones changed regions
+    COUNTER_LOD_SKIPPED,
+    COUNTER_LOD_HOPS,
+    COUNTER_COUNT
+};
+
+#ifdef ZOMBIES_STATS
+
+#include "clock.h"
+
+void statsRecord(enum StatsPhase, long long nanoseconds);
+void statsAdd(enum StatsCounter, long long amount);
+// Writes the report straight away
+void statsReport(void);
+
+#define STATS_BEGIN(phase) long long statsStart_##phase = monotonicNanoseconds()
+#define STATS_END(phase) statsRecord(phase, monotonicNanoseconds() - statsStart_##phase)
+#define STATS_COUNT(counter, amount) statsAdd(counter, amount)
+
+#else
+
+#define STATS_BEGIN(phase) ((void)0)
+#define STATS_END(phase) ((void)0)
+// amount is still looked at, so a count kept only for the stats doesn't trip unused variable warnings
+#define STATS_COUNT(counter, amount) ((void)(amount))
+
+#endif
+
+#endif
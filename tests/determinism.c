@@ -0,0 +1,357 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "game.h"
+#include "pool.h"
+
+/*
+    Checks that the game plays out exactly the same however it is run. Each check plays the same inputs two
+    ways, hashes where the player and every zombie stand after every tick, and fails at the first tick the
+    two disagree on.
+
+        determinism SOURCE
+        determinism --write-trace FILE SOURCE
+        determinism --check-trace FILE SOURCE
+
+    SOURCE is the top of the source tree, with maps/warehouse.txt and tests/room.txt in it. Exits with 1 if
+    any check failed. The build links this against the engine built with and without vector lanes (see
+    game.c), and those can't share a program, so the two write and check a trace of the same games instead:
+    one hash a line, for every tick.
+*/
+
+#define SEED 7
+#define TICKS 400
+// Big enough that the horde is split over a pool
+#define HORDE 6000
+// Ticks between snapshots taken in checkSnapshots, and between forks
+#define SAVE_EVERY 7
+#define FORK_EVERY 50
+// Long straight walks, which take the player well away from where a field cut off at FLOW_RADIUS was searched
+#define WALK "ddddddddddddddddddddddddddddddddssssssssssssssssssssssssssssssss"
+
+static unsigned long long hashPositions(const struct Game*);
+static char nextInput(unsigned long long* inputState);
+static void playTicks(struct Game*, unsigned long long* inputState, int ticks, unsigned long long* hashes);
+static int compareHashes(const char* check, const unsigned long long* expected, const unsigned long long* actual, int ticks);
+static struct Map* loadTestMap(const char* source, const char* name);
+static int checkPool(const struct Map* warehouse);
+static int checkFlowField(const struct Map* room);
+static int checkSnapshots(const char* check, const struct Map*, int numZombies, char levelOfDetail);
+static int checkPositions(const char* check, const struct Map*, int numZombies, const char* walk);
+static void traceGames(const struct Map* warehouse, unsigned long long* hashes);
+static int writeTrace(const char* path, const struct Map* warehouse);
+static int checkTrace(const char* path, const struct Map* warehouse);
+
+int main(int argc, char* argv[]) {
+    int tracing = argc == 4 && (strcmp(argv[1], "--write-trace") == 0 || strcmp(argv[1], "--check-trace") == 0);
+    if (argc != 2 && !tracing) {
+        printf("usage: determinism [--write-trace FILE | --check-trace FILE] SOURCE\n");
+        return 1;
+    }
+    if (tracing) {
+        struct Map* warehouse = loadTestMap(argv[3], "maps/warehouse.txt");
+        if (warehouse == NULL) {
+            return 1;
+        }
+        int failed = strcmp(argv[1], "--write-trace") == 0 ? writeTrace(argv[2], warehouse) : checkTrace(argv[2], warehouse);
+        destroyMap(warehouse);
+        return failed;
+    }
+
+    struct Map* warehouse = loadTestMap(argv[1], "maps/warehouse.txt");
+    struct Map* room = loadTestMap(argv[1], "tests/room.txt");
+    struct Map* office = createOfficeMap();
+    if (warehouse == NULL || room == NULL) {
+        destroyMap(warehouse);
+        destroyMap(room);
+        return 1;
+    }
+
+    int failed = checkPool(warehouse);
+    failed |= checkFlowField(room);
+    failed |= checkSnapshots("snapshots on the office", office, 40, 0);
+    failed |= checkSnapshots("snapshots on the warehouse, level of detail", warehouse, HORDE, 1);
+    failed |= checkPositions("positions on the office", office, 40, NULL);
+    failed |= checkPositions("positions on the warehouse", warehouse, HORDE, WALK);
+
+    destroyMap(warehouse);
+    destroyMap(room);
+    destroyMap(office);
+    return failed;
+}
+
+static struct Map* loadTestMap(const char* source, const char* name) {
+    char path[4096];
+    char error[100];
+    snprintf(path, sizeof(path), "%s/%s", source, name);
+    struct Map* map = loadMap(path, error, sizeof(error));
+    if (map == NULL) {
+        printf("%s\n", error);
+    }
+    return map;
+}
+
+// FNV-1a over the player's and every zombie's tile
+static unsigned long long hashPositions(const struct Game* game) {
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    hash = (hash ^ (unsigned long long)(game -> Player.ycoord << 16 | game -> Player.xcoord)) * 0x100000001B3ULL;
+    for (int i = 0; i < game -> numZombies; i++) {
+        hash = (hash ^ (unsigned long long)(game -> zombies[i].ycoord << 16 | game -> zombies[i].xcoord)) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static char nextInput(unsigned long long* inputState) {
+    static const char inputs[5] = {'w', 'a', 's', 'd', '.'};
+    return inputs[nextRandom(inputState) % 5];
+}
+
+// Plays ticks of random input, starting a new round whenever one ends, and keeps the hash after each
+static void playTicks(struct Game* game, unsigned long long* inputState, int ticks, unsigned long long* hashes) {
+    for (int tick = 0; tick < ticks; tick++) {
+        if (stepGame(game, nextInput(inputState)) != GAME_RUNNING) {
+            resetGame(game);
+        }
+        hashes[tick] = hashPositions(game);
+    }
+}
+
+static int compareHashes(const char* check, const unsigned long long* expected, const unsigned long long* actual, int ticks) {
+    for (int tick = 0; tick < ticks; tick++) {
+        if (expected[tick] != actual[tick]) {
+            printf("%s: FAILED, first different at tick %d\n", check, tick);
+            return 1;
+        }
+    }
+    printf("%s: ok\n", check);
+    return 0;
+}
+
+// Zombies proposed on one thread against the same zombies spread over pools of different sizes
+static int checkPool(const struct Map* warehouse) {
+    static const int threads[2] = {2, 3};
+    unsigned long long expected[TICKS];
+    unsigned long long actual[TICKS];
+    int failed = 0;
+
+    struct Game* game = createGame(warehouse, SEED, HORDE);
+    if (game == NULL) {
+        printf("pool: FAILED, not enough memory\n");
+        return 1;
+    }
+    unsigned long long inputState = SEED;
+    playTicks(game, &inputState, TICKS, expected);
+
+    for (int i = 0; i < 2; i++) {
+        struct Pool* pool = createPool(threads[i]);
+        if (pool == NULL) {
+            printf("pool: FAILED, no threads\n");
+            failed = 1;
+            break;
+        }
+        seedGame(game, SEED);
+        game -> pool = pool;
+        inputState = SEED;
+        playTicks(game, &inputState, TICKS, actual);
+        char check[32];
+        snprintf(check, sizeof(check), "pool of %d", threads[i]);
+        failed |= compareHashes(check, expected, actual, TICKS);
+        game -> pool = NULL;
+        destroyPool(pool);
+    }
+    destroyGame(game);
+    return failed;
+}
+
+/*
+    A flow field stepped along with the player against one built from scratch every tick. Only a field that
+    reaches every cell comes out the same both ways, so this runs on a room small enough that it always does.
+*/
+static int checkFlowField(const struct Map* room) {
+    unsigned long long expected[TICKS];
+    unsigned long long actual[TICKS];
+
+    struct Game* game = createGame(room, SEED, 12);
+    if (game == NULL) {
+        printf("flow field: FAILED, not enough memory\n");
+        return 1;
+    }
+    unsigned long long inputState = SEED;
+    playTicks(game, &inputState, TICKS, expected);
+    refreshFlowField(game);
+    if (!game -> fieldComplete) {
+        printf("flow field: FAILED, the room's field is cut off\n");
+        destroyGame(game);
+        return 1;
+    }
+
+    seedGame(game, SEED);
+    inputState = SEED;
+    for (int tick = 0; tick < TICKS; tick++) {
+        game -> fieldPathLength = FLOW_PATH_MAX + 1;
+        if (stepGame(game, nextInput(&inputState)) != GAME_RUNNING) {
+            resetGame(game);
+        }
+        actual[tick] = hashPositions(game);
+    }
+    destroyGame(game);
+    return compareHashes("flow field", expected, actual, TICKS);
+}
+
+/*
+    A game played straight through against one that keeps wandering off for a few ticks and being restored to
+    where it was, and every so often is swapped for a fork of itself.
+*/
+static int checkSnapshots(const char* check, const struct Map* map, int numZombies, char levelOfDetail) {
+    unsigned long long expected[TICKS];
+    unsigned long long actual[TICKS];
+
+    struct Game* game = createGame(map, SEED, numZombies);
+    struct GameSnapshot* saved = game == NULL ? NULL : malloc(snapshotSize(game));
+    if (saved == NULL) {
+        printf("%s: FAILED, not enough memory\n", check);
+        destroyGame(game);
+        return 1;
+    }
+    game -> levelOfDetail = levelOfDetail;
+    unsigned long long inputState = SEED;
+    playTicks(game, &inputState, TICKS, expected);
+
+    seedGame(game, SEED);
+    inputState = SEED;
+    unsigned long long detourState = SEED + 1;
+    for (int tick = 0; tick < TICKS; tick++) {
+        if (tick % SAVE_EVERY == SAVE_EVERY / 2) {
+            saveGame(game, saved);
+            int detour = 1 + tick / SAVE_EVERY % 5;
+            for (int i = 0; i < detour; i++) {
+                if (stepGame(game, nextInput(&detourState)) != GAME_RUNNING) {
+                    break;
+                }
+            }
+            restoreGame(game, saved);
+        }
+        if (tick % FORK_EVERY == FORK_EVERY / 2) {
+            struct Game* fork = forkGame(game);
+            if (fork == NULL) {
+                printf("%s: FAILED, not enough memory\n", check);
+                free(saved);
+                destroyGame(game);
+                return 1;
+            }
+            destroyGame(game);
+            game = fork;
+        }
+        if (stepGame(game, nextInput(&inputState)) != GAME_RUNNING) {
+            resetGame(game);
+        }
+        actual[tick] = hashPositions(game);
+    }
+    free(saved);
+    destroyGame(game);
+    return compareHashes(check, expected, actual, TICKS);
+}
+
+/*
+    A game played on against one put back on the board before every tick from nothing but the tick and where
+    everyone stands, the way the solver keeps its states. That only works if the flow field comes out the same
+    from the player's tile alone, which on a map wider than FLOW_RADIUS means a cut off field mustn't depend on
+    where the player has been. The player plays walk over and over, or random input if it is NULL.
+*/
+static int checkPositions(const char* check, const struct Map* map, int numZombies, const char* walk) {
+    unsigned long long expected[TICKS];
+    unsigned long long actual[TICKS];
+
+    struct Game* game = createGame(map, SEED, numZombies);
+    struct Game* placed = createGame(map, SEED, numZombies);
+    struct Spawn* zombies = malloc(numZombies * sizeof(struct Spawn));
+    if (game == NULL || placed == NULL || zombies == NULL) {
+        printf("%s: FAILED, not enough memory\n", check);
+        destroyGame(game);
+        destroyGame(placed);
+        free(zombies);
+        return 1;
+    }
+    unsigned long long inputState = SEED;
+    for (int tick = 0; tick < TICKS; tick++) {
+        struct Spawn player = {game -> Player.xcoord, game -> Player.ycoord};
+        for (int i = 0; i < numZombies; i++) {
+            zombies[i].xcoord = game -> zombies[i].xcoord;
+            zombies[i].ycoord = game -> zombies[i].ycoord;
+        }
+        placeActors(placed, player, zombies, game -> ticks);
+        placed -> roundKey = game -> roundKey;
+
+        char input = walk != NULL ? walk[tick % strlen(walk)] : nextInput(&inputState);
+        enum GameOutcome outcome = stepGame(game, input);
+        stepGame(placed, input);
+        expected[tick] = hashPositions(game);
+        actual[tick] = hashPositions(placed);
+        if (outcome != GAME_RUNNING) {
+            resetGame(game);
+        }
+    }
+    destroyGame(game);
+    destroyGame(placed);
+    free(zombies);
+    return compareHashes(check, expected, actual, TICKS);
+}
+
+// The traced games: a big horde on the warehouse, mostly wandering, then a small one on the office, mostly chasing
+static void traceGames(const struct Map* warehouse, unsigned long long* hashes) {
+    struct Map* office = createOfficeMap();
+    const struct Map* maps[2] = {warehouse, office};
+    const int hordes[2] = {HORDE, 40};
+    for (int i = 0; i < 2; i++) {
+        struct Game* game = createGame(maps[i], SEED, hordes[i]);
+        if (game == NULL) {
+            memset(hashes + i * TICKS, 0, TICKS * sizeof(hashes[0]));
+            continue;
+        }
+        unsigned long long inputState = SEED;
+        playTicks(game, &inputState, TICKS, hashes + i * TICKS);
+        destroyGame(game);
+    }
+    destroyMap(office);
+}
+
+static int writeTrace(const char* path, const struct Map* warehouse) {
+    unsigned long long hashes[2 * TICKS];
+    traceGames(warehouse, hashes);
+    FILE* out = fopen(path, "w");
+    if (out == NULL) {
+        printf("Can't write %s.\n", path);
+        return 1;
+    }
+    for (int tick = 0; tick < 2 * TICKS; tick++) {
+        fprintf(out, "%016llX\n", hashes[tick]);
+    }
+    int failed = ferror(out);
+    failed = fclose(out) != 0 || failed;
+    if (failed) {
+        printf("Can't write %s.\n", path);
+    }
+    return failed;
+}
+
+static int checkTrace(const char* path, const struct Map* warehouse) {
+    unsigned long long expected[2 * TICKS];
+    unsigned long long actual[2 * TICKS];
+    FILE* in = fopen(path, "r");
+    if (in == NULL) {
+        printf("Can't read %s.\n", path);
+        return 1;
+    }
+    int read = 0;
+    while (read < 2 * TICKS && fscanf(in, "%llx", &expected[read]) == 1) {
+        read++;
+    }
+    fclose(in);
+    if (read != 2 * TICKS) {
+        printf("%s holds %d ticks rather than %d.\n", path, read, 2 * TICKS);
+        return 1;
+    }
+    traceGames(warehouse, actual);
+    return compareHashes("trace", expected, actual, 2 * TICKS);
+}